@@ -0,0 +1,462 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include "BatchSimulator.h"
+#include "ThreadPool.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define BATCH_USE_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BATCH_USE_SSE2
+#endif
+
+namespace
+{
+    // Each pack type holds WIDTH floats with the same handful of operations; comparisons give all-ones or
+    // all-zero lanes, which select() and the bitwise operators then use as masks. The kernel below is
+    // written once against this interface.
+#if defined(BATCH_USE_AVX)
+    struct Pack
+    {
+        static constexpr int WIDTH = 8;
+        static constexpr const char *NAME = "AVX";
+        __m256 v;
+
+        static Pack load(const float *p)  { return { _mm256_loadu_ps(p) }; }
+        static Pack splat(float value)    { return { _mm256_set1_ps(value) }; }
+        void store(float *p) const        { _mm256_storeu_ps(p, v); }
+    };
+    inline Pack operator+(Pack a, Pack b)  { return { _mm256_add_ps(a.v, b.v) }; }
+    inline Pack operator-(Pack a, Pack b)  { return { _mm256_sub_ps(a.v, b.v) }; }
+    inline Pack operator*(Pack a, Pack b)  { return { _mm256_mul_ps(a.v, b.v) }; }
+    inline Pack operator&(Pack a, Pack b)  { return { _mm256_and_ps(a.v, b.v) }; }
+    inline Pack operator|(Pack a, Pack b)  { return { _mm256_or_ps(a.v, b.v) }; }
+    inline Pack and_not(Pack a, Pack b)    { return { _mm256_andnot_ps(b.v, a.v) }; }  // a & ~b
+    inline Pack operator==(Pack a, Pack b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+    inline Pack operator< (Pack a, Pack b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+    inline Pack operator<=(Pack a, Pack b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+    inline Pack operator> (Pack a, Pack b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+    inline Pack operator>=(Pack a, Pack b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+    inline Pack select(Pack mask, Pack a, Pack b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+    inline Pack negate(Pack a)             { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)) }; }
+    inline Pack absolute(Pack a)           { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+    inline bool any(Pack mask)             { return _mm256_movemask_ps(mask.v) != 0; }
+    inline bool all(Pack mask)             { return _mm256_movemask_ps(mask.v) == 0xFF; }
+#elif defined(BATCH_USE_SSE2)
+    struct Pack
+    {
+        static constexpr int WIDTH = 4;
+        static constexpr const char *NAME = "SSE2";
+        __m128 v;
+
+        static Pack load(const float *p)  { return { _mm_loadu_ps(p) }; }
+        static Pack splat(float value)    { return { _mm_set1_ps(value) }; }
+        void store(float *p) const        { _mm_storeu_ps(p, v); }
+    };
+    inline Pack operator+(Pack a, Pack b)  { return { _mm_add_ps(a.v, b.v) }; }
+    inline Pack operator-(Pack a, Pack b)  { return { _mm_sub_ps(a.v, b.v) }; }
+    inline Pack operator*(Pack a, Pack b)  { return { _mm_mul_ps(a.v, b.v) }; }
+    inline Pack operator&(Pack a, Pack b)  { return { _mm_and_ps(a.v, b.v) }; }
+    inline Pack operator|(Pack a, Pack b)  { return { _mm_or_ps(a.v, b.v) }; }
+    inline Pack and_not(Pack a, Pack b)    { return { _mm_andnot_ps(b.v, a.v) }; }
+    inline Pack operator==(Pack a, Pack b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+    inline Pack operator< (Pack a, Pack b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+    inline Pack operator<=(Pack a, Pack b) { return { _mm_cmple_ps(a.v, b.v) }; }
+    inline Pack operator> (Pack a, Pack b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+    inline Pack operator>=(Pack a, Pack b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+    inline Pack select(Pack mask, Pack a, Pack b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+    inline Pack negate(Pack a)             { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+    inline Pack absolute(Pack a)           { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+    inline bool any(Pack mask)             { return _mm_movemask_ps(mask.v) != 0; }
+    inline bool all(Pack mask)             { return _mm_movemask_ps(mask.v) == 0xF; }
+#else
+    // Plain C++ for targets without SSE2: one lane, masks kept as bit patterns like the vector versions
+    struct Pack
+    {
+        static constexpr int WIDTH = 1;
+        static constexpr const char *NAME = "scalar";
+        float v;
+
+        static Pack load(const float *p)  { return { *p }; }
+        static Pack splat(float value)    { return { value }; }
+        void store(float *p) const        { *p = v; }
+    };
+    inline uint32_t bits(float value)     { uint32_t result; std::memcpy(&result, &value, 4); return result; }
+    inline Pack from_bits(uint32_t value) { Pack result; std::memcpy(&result.v, &value, 4); return result; }
+    inline Pack mask(bool value)          { return from_bits(value ? ~0u : 0u); }
+
+    inline Pack operator+(Pack a, Pack b)  { return { a.v + b.v }; }
+    inline Pack operator-(Pack a, Pack b)  { return { a.v - b.v }; }
+    inline Pack operator*(Pack a, Pack b)  { return { a.v * b.v }; }
+    inline Pack operator&(Pack a, Pack b)  { return from_bits(bits(a.v) & bits(b.v)); }
+    inline Pack operator|(Pack a, Pack b)  { return from_bits(bits(a.v) | bits(b.v)); }
+    inline Pack and_not(Pack a, Pack b)    { return from_bits(bits(a.v) & ~bits(b.v)); }
+    inline Pack operator==(Pack a, Pack b) { return mask(a.v == b.v); }
+    inline Pack operator< (Pack a, Pack b) { return mask(a.v <  b.v); }
+    inline Pack operator<=(Pack a, Pack b) { return mask(a.v <= b.v); }
+    inline Pack operator> (Pack a, Pack b) { return mask(a.v >  b.v); }
+    inline Pack operator>=(Pack a, Pack b) { return mask(a.v >= b.v); }
+    inline Pack select(Pack m, Pack a, Pack b) { return bits(m.v) != 0 ? a : b; }
+    inline Pack negate(Pack a)             { return from_bits(bits(a.v) ^ 0x80000000u); }
+    inline Pack absolute(Pack a)           { return from_bits(bits(a.v) & 0x7FFFFFFFu); }
+    inline bool any(Pack mask)             { return bits(mask.v) != 0; }
+    inline bool all(Pack mask)             { return bits(mask.v) != 0; }
+#endif
+
+    // Blocks of matches each thread steps through all ticks, sized so a block's arrays stay in L2
+    constexpr int MATCHES_PER_BLOCK = 1024;
+
+    // How close the built-in player gets to the middle before it stops moving
+    constexpr float TRACKING_DEAD_ZONE = 0.1f;
+
+    float phase_value(MatchPhase phase) { return (float) phase; }
+}
+
+const int BatchSimulator::PACK_WIDTH = Pack::WIDTH;
+const char *const BatchSimulator::INSTRUCTION_SET = Pack::NAME;
+
+BatchSimulator::BatchSimulator(int match_count) : m_count(0)
+{
+    reset(match_count);
+}
+
+void BatchSimulator::reset(int match_count)
+{
+    m_count = std::max(match_count, 0);
+    size_t padded = (m_count + Pack::WIDTH - 1) / Pack::WIDTH * Pack::WIDTH;
+
+    const BasicMatch<float> defaults;
+    m_ball_x.assign(padded, defaults.ball_position.x);
+    m_ball_y.assign(padded, defaults.ball_position.y);
+    m_ball_dx.assign(padded, defaults.ball_movement.x);
+    m_ball_dy.assign(padded, defaults.ball_movement.y);
+    m_ball_speed.assign(padded, defaults.ball_speed);
+    m_left_y.assign(padded, defaults.paddle_position.y);
+    m_right_y.assign(padded, defaults.right_paddle_position.y);
+    m_left_movement.assign(padded, 0.0f);
+    m_right_movement.assign(padded, 0.0f);
+    m_left_distance.assign(padded, defaults.paddle_y_distance);
+    m_right_distance.assign(padded, defaults.paddle_right_y_distance);
+    m_phase.assign(padded, phase_value(defaults.phase));
+    m_phase_timer.assign(padded, defaults.phase_timer);
+    m_left_score.assign(padded, 0.0f);
+    m_right_score.assign(padded, 0.0f);
+    m_serve_direction.assign(padded, defaults.serve_direction);
+    m_left_input.assign(padded, 0.0f);
+    m_right_input.assign(padded, 0.0f);
+    m_hit_count.assign(padded, 0.0f);
+    m_point_count.assign(padded, 0.0f);
+}
+
+void BatchSimulator::reset_match(int match_index)
+{
+    const BasicMatch<float> defaults;
+    m_ball_x[match_index] = defaults.ball_position.x;
+    m_ball_y[match_index] = defaults.ball_position.y;
+    m_ball_dx[match_index] = defaults.ball_movement.x;
+    m_ball_dy[match_index] = defaults.ball_movement.y;
+    m_ball_speed[match_index] = defaults.ball_speed;
+    m_left_y[match_index] = defaults.paddle_position.y;
+    m_right_y[match_index] = defaults.right_paddle_position.y;
+    m_left_movement[match_index] = 0.0f;
+    m_right_movement[match_index] = 0.0f;
+    m_left_distance[match_index] = defaults.paddle_y_distance;
+    m_right_distance[match_index] = defaults.paddle_right_y_distance;
+    m_phase[match_index] = phase_value(defaults.phase);
+    m_phase_timer[match_index] = defaults.phase_timer;
+    m_left_score[match_index] = 0.0f;
+    m_right_score[match_index] = 0.0f;
+    m_serve_direction[match_index] = defaults.serve_direction;
+    m_left_input[match_index] = 0.0f;
+    m_right_input[match_index] = 0.0f;
+}
+
+template <typename P>
+void BatchSimulator::step_lanes(int begin, int end, bool serve, float delta_time)
+{
+    // Constants are the same float expressions update_match() uses, so every lane rounds identically
+    const BasicMatch<float> defaults;
+    const P zero = P::splat(0.0f), one = P::splat(1.0f), minus_one = P::splat(-1.0f),
+            step = P::splat(delta_time),
+            serve_mask = serve ? (zero == zero) : (zero < zero),
+            serve_phase = P::splat(phase_value(PHASE_SERVE)),
+            rally_phase = P::splat(phase_value(PHASE_RALLY)),
+            point_phase = P::splat(phase_value(PHASE_POINT_SCORED)),
+            over_phase = P::splat(phase_value(PHASE_MATCH_OVER)),
+            paddle_speed = P::splat(defaults.paddle_speed),
+            travel_top = P::splat(PADDLE_TRAVEL_TOP),
+            travel_length = P::splat(PADDLE_TRAVEL_LENGTH),
+            left_x = P::splat(defaults.paddle_position.x),
+            right_x = P::splat(defaults.right_paddle_position.x),
+            left_reach_x = P::splat((INIT_BALL_SCALE.x + INIT_PLAYER_1_SCALE.x) / 2),
+            left_reach_y = P::splat((INIT_BALL_SCALE.y + INIT_PLAYER_1_SCALE.y) / 2),
+            right_reach_x = P::splat((INIT_BALL_SCALE.x + INIT_PLAYER_2_SCALE.x) / 2),
+            right_reach_y = P::splat((INIT_BALL_SCALE.y + INIT_PLAYER_2_SCALE.y) / 2),
+            speed_growth = P::splat(BALL_SPEED_GROWTH),
+            wall = P::splat(WALL_Y), minus_wall = P::splat(-WALL_Y),
+            court_edge = P::splat(COURT_HALF_WIDTH), minus_court_edge = P::splat(-COURT_HALF_WIDTH),
+            points_to_win = P::splat((float) POINTS_TO_WIN),
+            pause = P::splat(POINT_PAUSE_DURATION),
+            initial_speed = P::splat(defaults.ball_speed),
+            initial_serve = P::splat(defaults.serve_direction);
+
+    for (int i = begin; i < end; i += P::WIDTH)
+    {
+        P ball_x = P::load(&m_ball_x[i]), ball_y = P::load(&m_ball_y[i]),
+          ball_dx = P::load(&m_ball_dx[i]), ball_dy = P::load(&m_ball_dy[i]),
+          ball_speed = P::load(&m_ball_speed[i]),
+          left_y = P::load(&m_left_y[i]), right_y = P::load(&m_right_y[i]),
+          left_movement = P::load(&m_left_movement[i]), right_movement = P::load(&m_right_movement[i]),
+          left_distance = P::load(&m_left_distance[i]), right_distance = P::load(&m_right_distance[i]),
+          phase = P::load(&m_phase[i]), phase_timer = P::load(&m_phase_timer[i]),
+          left_score = P::load(&m_left_score[i]), right_score = P::load(&m_right_score[i]),
+          serve_direction = P::load(&m_serve_direction[i]),
+          left_input = P::load(&m_left_input[i]), right_input = P::load(&m_right_input[i]);
+
+        /* PHASE */
+        P is_over = phase == over_phase,
+          is_scored = phase == point_phase,
+          is_playing = phase <= rally_phase;
+
+        phase_timer = select(is_scored, phase_timer - step, phase_timer);
+        P round_reset = is_scored & (phase_timer <= zero),
+          match_reset = is_over & serve_mask,
+          is_serving = (phase == serve_phase) & serve_mask;
+
+        ball_dx = select(is_serving, serve_direction, ball_dx);
+        phase = select(is_serving, rally_phase, phase);
+
+        /* PADDLES */
+        P new_left_movement = select((left_input > zero) & (left_distance > zero), one, zero);
+        new_left_movement = select((left_input < zero) & (left_distance < travel_length), minus_one, new_left_movement);
+        P new_right_movement = select((right_input > zero) & (right_distance > zero), one, zero);
+        new_right_movement = select((right_input < zero) & (right_distance < travel_length), minus_one, new_right_movement);
+
+        /* GAME LOGIC */
+        P new_ball_x = ball_x + ball_dx * ball_speed * step,
+          new_ball_y = ball_y + ball_dy * ball_speed * step,
+          new_left_y = left_y + new_left_movement * paddle_speed * step,
+          new_right_y = right_y + new_right_movement * paddle_speed * step;
+
+        P new_left_distance = travel_top - new_left_y,
+          new_right_distance = travel_top - new_right_y;
+
+        P left_hit = (absolute(new_ball_x - left_x) - left_reach_x <= zero) &
+                     (absolute(new_ball_y - new_left_y) - left_reach_y <= zero);
+        P right_hit = and_not((absolute(new_ball_x - right_x) - right_reach_x <= zero) &
+                              (absolute(new_ball_y - new_right_y) - right_reach_y <= zero), left_hit);
+        P any_hit = left_hit | right_hit;
+
+        P new_ball_dx = select(left_hit, one, select(right_hit, minus_one, ball_dx));
+        P new_ball_speed = select(any_hit, ball_speed * speed_growth, ball_speed);
+        P new_ball_dy = ball_dy;
+        new_ball_dy = select(left_hit & (new_left_movement < zero), minus_one, select(left_hit & (new_left_movement > zero), one, new_ball_dy));
+        new_ball_dy = select(right_hit & (new_right_movement < zero), minus_one, select(right_hit & (new_right_movement > zero), one, new_ball_dy));
+        new_ball_dy = select((new_ball_y >= wall) | (new_ball_y <= minus_wall), negate(new_ball_dy), new_ball_dy);
+
+        /* SCORING */
+        P is_out = (new_ball_x >= court_edge) | (new_ball_x <= minus_court_edge),
+          is_left_point = is_out & (new_ball_x > zero),
+          is_right_point = and_not(is_out, is_left_point);
+
+        P new_left_score = select(is_left_point, left_score + one, left_score),
+          new_right_score = select(is_right_point, right_score + one, right_score);
+        new_ball_dx = select(is_out, zero, new_ball_dx);
+        new_ball_dy = select(is_out, zero, new_ball_dy);
+        P new_serve_direction = select(is_out, negate(serve_direction), serve_direction);
+        new_left_movement = select(is_out, zero, new_left_movement);
+        new_right_movement = select(is_out, zero, new_right_movement);
+
+        P is_won = is_out & ((new_left_score >= points_to_win) | (new_right_score >= points_to_win));
+        P new_phase = select(is_won, over_phase, select(is_out, point_phase, phase));
+        P new_phase_timer = select(and_not(is_out, is_won), pause, phase_timer);
+
+        /* Only serving and rallying matches get this far in update_match(). Nearly always that is every
+           lane, and the blend can be skipped. */
+        if (all(is_playing))
+        {
+            ball_x = new_ball_x; ball_y = new_ball_y;
+            ball_dx = new_ball_dx; ball_dy = new_ball_dy;
+            ball_speed = new_ball_speed;
+            left_y = new_left_y; right_y = new_right_y;
+            left_movement = new_left_movement; right_movement = new_right_movement;
+            left_distance = new_left_distance; right_distance = new_right_distance;
+            left_score = new_left_score; right_score = new_right_score;
+            serve_direction = new_serve_direction;
+            phase = new_phase; phase_timer = new_phase_timer;
+        }
+        else
+        {
+            ball_x = select(is_playing, new_ball_x, ball_x);
+            ball_y = select(is_playing, new_ball_y, ball_y);
+            ball_dx = select(is_playing, new_ball_dx, ball_dx);
+            ball_dy = select(is_playing, new_ball_dy, ball_dy);
+            ball_speed = select(is_playing, new_ball_speed, ball_speed);
+            left_y = select(is_playing, new_left_y, left_y);
+            right_y = select(is_playing, new_right_y, right_y);
+            left_movement = select(is_playing, new_left_movement, left_movement);
+            right_movement = select(is_playing, new_right_movement, right_movement);
+            left_distance = select(is_playing, new_left_distance, left_distance);
+            right_distance = select(is_playing, new_right_distance, right_distance);
+            left_score = select(is_playing, new_left_score, left_score);
+            right_score = select(is_playing, new_right_score, right_score);
+            serve_direction = select(is_playing, new_serve_direction, serve_direction);
+            phase = select(is_playing, new_phase, phase);
+            phase_timer = select(is_playing, new_phase_timer, phase_timer);
+        }
+
+        /* RESETS: a new round keeps the score and serve order, a new match keeps nothing */
+        P any_reset = round_reset | match_reset;
+        if (any(any_reset))
+        {
+            ball_x = select(any_reset, zero, ball_x);
+            ball_y = select(any_reset, zero, ball_y);
+            ball_dx = select(any_reset, zero, ball_dx);
+            ball_dy = select(any_reset, zero, ball_dy);
+            ball_speed = select(any_reset, initial_speed, ball_speed);
+            left_y = select(any_reset, zero, left_y);
+            right_y = select(any_reset, zero, right_y);
+            left_movement = select(any_reset, zero, left_movement);
+            right_movement = select(any_reset, zero, right_movement);
+            left_distance = select(any_reset, zero, left_distance);
+            right_distance = select(any_reset, zero, right_distance);
+            phase = select(any_reset, serve_phase, phase);
+            phase_timer = select(any_reset, zero, phase_timer);
+            left_score = select(match_reset, zero, left_score);
+            right_score = select(match_reset, zero, right_score);
+            serve_direction = select(match_reset, initial_serve, serve_direction);
+        }
+
+        ball_x.store(&m_ball_x[i]); ball_y.store(&m_ball_y[i]);
+        ball_dx.store(&m_ball_dx[i]); ball_dy.store(&m_ball_dy[i]);
+        ball_speed.store(&m_ball_speed[i]);
+        left_y.store(&m_left_y[i]); right_y.store(&m_right_y[i]);
+        left_movement.store(&m_left_movement[i]); right_movement.store(&m_right_movement[i]);
+        left_distance.store(&m_left_distance[i]); right_distance.store(&m_right_distance[i]);
+        phase.store(&m_phase[i]); phase_timer.store(&m_phase_timer[i]);
+        left_score.store(&m_left_score[i]); right_score.store(&m_right_score[i]);
+        serve_direction.store(&m_serve_direction[i]);
+
+        (P::load(&m_hit_count[i]) + select(is_playing & any_hit, one, zero)).store(&m_hit_count[i]);
+        (P::load(&m_point_count[i]) + select(is_playing & is_out, one, zero)).store(&m_point_count[i]);
+    }
+}
+
+template <typename P>
+void BatchSimulator::track_lanes(int begin, int end)
+{
+    const P zero = P::splat(0.0f), one = P::splat(1.0f), minus_one = P::splat(-1.0f),
+            dead_zone = P::splat(TRACKING_DEAD_ZONE);
+
+    for (int i = begin; i < end; i += P::WIDTH)
+    {
+        P ball_y = P::load(&m_ball_y[i]),
+          ball_dx = P::load(&m_ball_dx[i]),
+          left_y = P::load(&m_left_y[i]),
+          right_y = P::load(&m_right_y[i]);
+
+        // While the ball is coming, the paddle is always moving one way or the other, so it angles the
+        // return; a paddle standing still would send it back flat and the rally would never end. Going
+        // back to the middle stops inside a dead zone instead.
+        P is_left_incoming = ball_dx < zero,
+          is_right_incoming = ball_dx > zero;
+
+        P left_up = select(is_left_incoming, ball_y >= left_y, zero > left_y + dead_zone),
+          left_down = and_not(select(is_left_incoming, ball_y < left_y, zero < left_y - dead_zone), left_up),
+          right_up = select(is_right_incoming, ball_y >= right_y, zero > right_y + dead_zone),
+          right_down = and_not(select(is_right_incoming, ball_y < right_y, zero < right_y - dead_zone), right_up);
+
+        select(left_up, one, select(left_down, minus_one, zero)).store(&m_left_input[i]);
+        select(right_up, one, select(right_down, minus_one, zero)).store(&m_right_input[i]);
+    }
+}
+
+void BatchSimulator::step(int begin, int end, bool serve, float delta_time)
+{
+    // The padding lanes past the last match are stepped too; nothing reads them
+    end = (end + Pack::WIDTH - 1) / Pack::WIDTH * Pack::WIDTH;
+    step_lanes<Pack>(begin, end, serve, delta_time);
+}
+
+void BatchSimulator::track_ball(int begin, int end)
+{
+    end = (end + Pack::WIDTH - 1) / Pack::WIDTH * Pack::WIDTH;
+    track_lanes<Pack>(begin, end);
+}
+
+void BatchSimulator::set_input(int match_index, int left_direction, int right_direction)
+{
+    m_left_input[match_index] = (float) left_direction;
+    m_right_input[match_index] = (float) right_direction;
+}
+
+BasicMatch<float> BatchSimulator::get_match(int match_index) const
+{
+    BasicMatch<float> match;
+    match.ball_position.x = m_ball_x[match_index];
+    match.ball_position.y = m_ball_y[match_index];
+    match.ball_movement.x = m_ball_dx[match_index];
+    match.ball_movement.y = m_ball_dy[match_index];
+    match.ball_speed = m_ball_speed[match_index];
+    match.paddle_position.y = m_left_y[match_index];
+    match.right_paddle_position.y = m_right_y[match_index];
+    match.paddle_movement.y = m_left_movement[match_index];
+    match.right_paddle_movement.y = m_right_movement[match_index];
+    match.paddle_y_distance = m_left_distance[match_index];
+    match.paddle_right_y_distance = m_right_distance[match_index];
+    match.phase = (MatchPhase) (int) m_phase[match_index];
+    match.phase_timer = m_phase_timer[match_index];
+    match.left_score = (int) m_left_score[match_index];
+    match.right_score = (int) m_right_score[match_index];
+    match.serve_direction = m_serve_direction[match_index];
+
+    return match;
+}
+
+long long BatchSimulator::get_hit_count(int begin, int end) const
+{
+    long long total = 0;
+    for (int i = begin; i < end; i++) total += (long long) m_hit_count[i];
+    return total;
+}
+
+long long BatchSimulator::get_point_count(int begin, int end) const
+{
+    long long total = 0;
+    for (int i = begin; i < end; i++) total += (long long) m_point_count[i];
+    return total;
+}
+
+BatchRunStats run_batch_simulation(int match_count, int tick_count, int thread_count, float delta_time)
+{
+    BatchSimulator simulator(match_count);
+    ThreadPool pool(thread_count);
+
+    int block_count = (match_count + MATCHES_PER_BLOCK - 1) / MATCHES_PER_BLOCK;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Each block runs every tick before the next block starts, so its arrays stay in cache throughout
+    pool.parallel_for(block_count, 1, [&](int first_block, int last_block)
+    {
+        for (int block = first_block; block < last_block; block++)
+        {
+            int begin = block * MATCHES_PER_BLOCK,
+                end = std::min(begin + MATCHES_PER_BLOCK, match_count);
+            for (int tick = 0; tick < tick_count; tick++)
+            {
+                simulator.track_ball(begin, end);
+                simulator.step(begin, end, true, delta_time);
+            }
+        }
+    });
+
+    BatchRunStats stats;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.match_ticks = (long long) match_count * tick_count;
+    stats.hits = simulator.get_hit_count(0, match_count);
+    stats.points = simulator.get_point_count(0, match_count);
+    return stats;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include "Match.h"
+
+// Many float matches stepped together for balancing runs. Every field update_match() touches lives in its
+// own array (one match per index), so each step loads a few matches' worth of each field into SIMD
+// registers and runs the whole tick on them at once: phases, serves, paddle input, collisions and
+// scoring. A lane gives exactly the results update_match() would for a match with the AI switched off
+// and the same inputs, provided the compiler does not contract multiplies and adds into fused
+// multiply-adds: the scalar code would get them and the intrinsics would not. MSVC's /fp:precise does
+// not contract; with GCC or Clang, build both this and Match.cpp with -ffp-contract=off whenever FMA is
+// enabled. The AI and AI toggle are not modelled; both paddles take their direction from the input
+// arrays, which track_ball() can fill with a simple built-in player.
+class BatchSimulator
+{
+private:
+    template <typename Pack> void step_lanes(int begin, int end, bool serve, float delta_time);
+    template <typename Pack> void track_lanes(int begin, int end);
+
+    int m_count;
+
+    // Ball
+    std::vector<float> m_ball_x, m_ball_y,
+                       m_ball_dx, m_ball_dy,
+                       m_ball_speed;
+
+    // Paddles, whose x never changes
+    std::vector<float> m_left_y, m_right_y,
+                       m_left_movement, m_right_movement,
+                       m_left_distance, m_right_distance;  // paddle_y_distance and paddle_right_y_distance
+
+    // Phase and scoring, held as floats so they fit the same registers; every value is a small integer
+    std::vector<float> m_phase, m_phase_timer,
+                       m_left_score, m_right_score,
+                       m_serve_direction;
+
+    // Per-lane input for the next step: -1 down, 0 still, 1 up
+    std::vector<float> m_left_input, m_right_input;
+
+    // Running totals for balancing
+    std::vector<float> m_hit_count, m_point_count;
+
+public:
+    // Lanes per SIMD register in this build; the arrays are padded to a multiple of it
+    static const int PACK_WIDTH;
+    static const char *const INSTRUCTION_SET;
+
+    explicit BatchSimulator(int match_count = 0);
+
+    // Puts every match back to a fresh Match and clears the totals
+    void reset(int match_count);
+
+    // Puts one match back to a fresh Match, leaving its totals alone
+    void reset_match(int match_index);
+
+    // begin and end must be multiples of PACK_WIDTH, or end the match count
+    void step(int begin, int end, bool serve, float delta_time);
+
+    // A player for both sides that chases the ball while it is coming their way and goes back to the
+    // middle while it is not
+    void track_ball(int begin, int end);
+
+    void set_input(int match_index, int left_direction, int right_direction);
+    void set_left_input(int match_index, int direction) { m_left_input[match_index] = (float) direction; };
+
+    // The match as update_match() would have it. The batch always runs on floats, whatever SimScalar is.
+    // The paddle-to-ball contact distances are not kept and come back as zero.
+    BasicMatch<float> get_match(int match_index) const;
+
+    long long get_hit_count(int begin, int end) const;
+    long long get_point_count(int begin, int end) const;
+
+    int const get_count() const { return m_count; };
+
+    // The arrays themselves, one float per match, for callers that read many matches at once
+    const float *get_ball_x()      const { return m_ball_x.data();      };
+    const float *get_ball_y()      const { return m_ball_y.data();      };
+    const float *get_ball_dx()     const { return m_ball_dx.data();     };
+    const float *get_ball_dy()     const { return m_ball_dy.data();     };
+    const float *get_ball_speed()  const { return m_ball_speed.data();  };
+    const float *get_left_y()      const { return m_left_y.data();      };
+    const float *get_right_y()     const { return m_right_y.data();     };
+    const float *get_phase()       const { return m_phase.data();       };
+    const float *get_left_score()  const { return m_left_score.data();  };
+    const float *get_right_score() const { return m_right_score.data(); };
+};
+
+struct BatchRunStats
+{
+    long long match_ticks = 0;
+    double    seconds = 0.0;
+    long long hits = 0;
+    long long points = 0;
+};
+
+// Steps match_count matches for tick_count ticks with both paddles on track_ball() and serving at once,
+// spread over a thread pool in cache-sized blocks of matches. thread_count counts the caller; 0 uses
+// every hardware thread.
+BatchRunStats run_batch_simulation(int match_count, int tick_count, int thread_count, float delta_time);
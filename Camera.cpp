@@ -0,0 +1,124 @@
+#define GL_SILENCE_DEPRECATION
+
+#include <cmath>
+#include "Camera.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+Camera::Camera(float half_width, float half_height) :
+    m_position(0.0f), m_shake_offset(0.0f), m_zoom(1.0f),
+    m_half_width(half_width), m_half_height(half_height),
+    m_follow_target(nullptr), m_follow_rate(0.0f),
+    m_shake_magnitude(0.0f), m_shake_duration(0.0f), m_shake_time_left(0.0f),
+    m_view_matrix(1.0f), m_is_dirty(true)
+{
+}
+
+void Camera::update(float delta_time)
+{
+    if (m_follow_target != nullptr)
+    {
+        // Exponential approach so the camera eases toward the target regardless of frame rate
+        float blend = 1.0f - std::exp(-m_follow_rate * delta_time);
+        m_position += (glm::vec3(m_follow_target->x, m_follow_target->y, 0.0f) - m_position) * blend;
+    }
+
+    m_shake_offset = glm::vec3(0.0f);
+    if (m_shake_time_left > 0.0f)
+    {
+        m_shake_time_left = std::fmax(m_shake_time_left - delta_time, 0.0f);
+
+        // Two incommensurate frequencies give an irregular but deterministic wobble that decays linearly
+        float t        = m_shake_duration - m_shake_time_left;
+        float strength = m_shake_magnitude * (m_shake_time_left / m_shake_duration);
+        m_shake_offset = glm::vec3(std::sin(t * 91.0f), std::cos(t * 67.0f), 0.0f) * strength;
+    }
+
+    rebuild_view_matrix();
+}
+
+void Camera::rebuild_view_matrix()
+{
+    glm::mat4 view_matrix = glm::scale(glm::mat4(1.0f), glm::vec3(m_zoom, m_zoom, 1.0f));
+    view_matrix = glm::translate(view_matrix, -(m_position + m_shake_offset));
+
+    if (view_matrix != m_view_matrix)
+    {
+        m_view_matrix = view_matrix;
+        m_is_dirty = true;
+    }
+}
+
+bool Camera::apply(ShaderProgram &program)
+{
+    if (!m_is_dirty) return false;
+
+    program.set_view_matrix(m_view_matrix);
+    m_is_dirty = false;
+    return true;
+}
+
+void Camera::pan(const glm::vec3 &delta)
+{
+    // Manual panning takes the camera off whatever it was following
+    m_follow_target = nullptr;
+    m_position += glm::vec3(delta.x, delta.y, 0.0f);
+}
+
+void Camera::zoom_by(float factor)
+{
+    m_zoom = std::fmin(std::fmax(m_zoom * factor, MIN_ZOOM), MAX_ZOOM);
+}
+
+void Camera::shake(float magnitude, float duration)
+{
+    if (duration <= 0.0f) return;
+
+    // A new shake never weakens one already in progress
+    if (magnitude * duration >= m_shake_magnitude * m_shake_time_left)
+    {
+        m_shake_magnitude = magnitude;
+        m_shake_duration  = duration;
+        m_shake_time_left = duration;
+    }
+}
+
+void Camera::reset()
+{
+    m_position        = glm::vec3(0.0f);
+    m_zoom            = 1.0f;
+    m_follow_target   = nullptr;
+    m_shake_time_left = 0.0f;
+    rebuild_view_matrix();
+}
+
+bool Camera::is_animating() const
+{
+    constexpr float SETTLED_DISTANCE = 0.001f;
+
+    if (m_shake_time_left > 0.0f) return true;
+    if (m_follow_target == nullptr) return false;
+
+    return std::fabs(m_follow_target->x - m_position.x) > SETTLED_DISTANCE ||
+           std::fabs(m_follow_target->y - m_position.y) > SETTLED_DISTANCE;
+}
+
+bool Camera::is_visible(const glm::vec3 &centre, const glm::vec3 &half_extents) const
+{
+    glm::vec3 visible_min = get_visible_min(),
+              visible_max = get_visible_max();
+
+    return centre.x + half_extents.x >= visible_min.x && centre.x - half_extents.x <= visible_max.x &&
+           centre.y + half_extents.y >= visible_min.y && centre.y - half_extents.y <= visible_max.y;
+}
+
+bool Camera::is_visible(const glm::mat4 &model_matrix) const
+{
+    // Bounding box of the transformed unit quad, which also covers rotated sprites
+    glm::vec3 centre = glm::vec3(model_matrix[3]);
+    glm::vec3 half_extents = glm::vec3(
+        std::fabs(model_matrix[0].x) + std::fabs(model_matrix[1].x),
+        std::fabs(model_matrix[0].y) + std::fabs(model_matrix[1].y),
+        0.0f) * 0.5f;
+
+    return is_visible(centre, half_extents);
+}
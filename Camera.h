@@ -0,0 +1,63 @@
+#pragma once
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "ShaderProgram.h"
+
+class Camera
+{
+private:
+    void rebuild_view_matrix();
+
+    glm::vec3 m_position;
+    glm::vec3 m_shake_offset;
+    float     m_zoom;
+
+    // Half extents of the projection at zoom 1, in world units
+    float m_half_width;
+    float m_half_height;
+
+    const glm::vec3 *m_follow_target;
+    float m_follow_rate;
+
+    float m_shake_magnitude;
+    float m_shake_duration;
+    float m_shake_time_left;
+
+    glm::mat4 m_view_matrix;
+    bool      m_is_dirty;
+
+public:
+    static constexpr float MIN_ZOOM = 0.25f,
+                           MAX_ZOOM = 4.0f;
+
+    Camera(float half_width, float half_height);
+
+    void update(float delta_time);
+
+    // Uploads the view matrix only if it changed since the last call; returns whether it did
+    bool apply(ShaderProgram &program);
+    void mark_dirty() { m_is_dirty = true; };
+
+    void pan(const glm::vec3 &delta);
+    void zoom_by(float factor);
+    void shake(float magnitude, float duration);
+    void reset();
+
+    // True while a shake is playing or the camera is still catching up with its follow target
+    bool is_animating() const;
+
+    void follow(const glm::vec3 *target, float rate) { m_follow_target = target; m_follow_rate = rate; };
+    void stop_following()                            { m_follow_target = nullptr;                     };
+
+    // Culling against the currently visible rectangle
+    bool is_visible(const glm::vec3 &centre, const glm::vec3 &half_extents) const;
+    bool is_visible(const glm::mat4 &model_matrix) const;
+
+    glm::vec3 const get_visible_min()  const { return m_position + m_shake_offset - glm::vec3(m_half_width, m_half_height, 0.0f) / m_zoom; };
+    glm::vec3 const get_visible_max()  const { return m_position + m_shake_offset + glm::vec3(m_half_width, m_half_height, 0.0f) / m_zoom; };
+    glm::vec3 const get_position()     const { return m_position;          };
+    float     const get_zoom()         const { return m_zoom;              };
+    bool      const is_following()     const { return m_follow_target != nullptr; };
+    glm::mat4 const &get_view_matrix() const { return m_view_matrix;       };
+};
@@ -0,0 +1,22 @@
+#include <algorithm>
+#include "ContactQueue.h"
+
+ContactQueue::ContactQueue(int capacity) : m_count(0), m_dropped_count(0)
+{
+    reset(capacity);
+}
+
+void ContactQueue::reset(int capacity)
+{
+    m_contacts.assign(std::max(capacity, 0), Contact());
+    m_count = 0;
+    m_dropped_count = 0;
+}
+
+void ContactQueue::push(const Contact *contacts, int count)
+{
+    int accepted = std::min(count, (int) m_contacts.size() - m_count);
+    std::copy(contacts, contacts + accepted, m_contacts.begin() + m_count);
+    m_count += accepted;
+    m_dropped_count += count - accepted;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include "Match.h"
+
+// Preallocated buffer of contacts from many matches, filled by update_match() during a tick and read
+// afterwards in one pass by whatever reacts to them (particles, camera shake, sound). It never grows:
+// contacts beyond the capacity are counted and dropped.
+class ContactQueue
+{
+private:
+    std::vector<Contact> m_contacts;
+    int m_count;
+    int m_dropped_count;
+
+public:
+    explicit ContactQueue(int capacity = 0);
+
+    // Sizes the buffer and empties it; room for MAX_CONTACTS_PER_STEP per match never drops anything
+    void reset(int capacity);
+
+    void push(const Contact *contacts, int count);
+    void clear() { m_count = 0; };
+
+    const Contact *begin() const { return m_contacts.data();           };
+    const Contact *end()   const { return m_contacts.data() + m_count; };
+
+    int const get_count()         const { return m_count;                  };
+    int const get_capacity()      const { return (int) m_contacts.size(); };
+    int const get_dropped_count() const { return m_dropped_count;          };
+};
@@ -0,0 +1,205 @@
+#include <chrono>
+#include "ControllerSampler.h"
+
+namespace
+{
+    int stick_direction(SDL_GameController *controller, SDL_GameControllerAxis axis)
+    {
+        // SDL's y axis grows downwards; paddles move up for a positive direction
+        float value = SDL_GameControllerGetAxis(controller, axis) / 32767.0f;
+        if (value < -ControllerSampler::STICK_DEAD_ZONE) return 1;
+        if (value > ControllerSampler::STICK_DEAD_ZONE) return -1;
+        return 0;
+    }
+}
+
+ControllerSampler::ControllerSampler() :
+    m_was_serve_down(false), m_was_toggle_ai_down(false),
+    m_is_serve_pending(false), m_is_toggle_ai_pending(false),
+    m_head(0), m_tail(0),
+    m_paddle_direction(0), m_right_paddle_direction(0),
+    m_is_running(false), m_sample_rate(DEFAULT_SAMPLE_RATE)
+{
+    for (int i = 0; i < MAX_CONTROLLERS; i++) m_controllers[i] = nullptr;
+}
+
+ControllerSampler::~ControllerSampler()
+{
+    stop();
+}
+
+void ControllerSampler::start(int sample_rate)
+{
+    if (m_is_running) return;
+
+    m_sample_rate = sample_rate > 0 ? sample_rate : DEFAULT_SAMPLE_RATE;
+    m_is_running = true;
+    m_thread = std::thread(&ControllerSampler::run, this);
+}
+
+void ControllerSampler::stop()
+{
+    if (m_is_running)
+    {
+        m_is_running = false;
+        m_thread.join();
+    }
+
+    for (int i = 0; i < MAX_CONTROLLERS; i++)
+    {
+        if (m_controllers[i] != nullptr) SDL_GameControllerClose(m_controllers[i]);
+        m_controllers[i] = nullptr;
+    }
+}
+
+void ControllerSampler::add_controller(int device_index)
+{
+    if (!SDL_IsGameController(device_index)) return;
+
+    // SDL also reports the controllers that were already plugged in at startup, and may report one twice
+    SDL_JoystickID instance_id = SDL_JoystickGetDeviceInstanceID(device_index);
+    std::lock_guard<std::mutex> lock(m_controllers_mutex);
+    int free_slot = -1;
+    for (int i = 0; i < MAX_CONTROLLERS; i++)
+    {
+        if (m_controllers[i] == nullptr)
+        {
+            if (free_slot < 0) free_slot = i;
+        }
+        else if (SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(m_controllers[i])) == instance_id)
+        {
+            return;
+        }
+    }
+
+    if (free_slot >= 0) m_controllers[free_slot] = SDL_GameControllerOpen(device_index);
+}
+
+void ControllerSampler::remove_controller(SDL_JoystickID instance_id)
+{
+    std::lock_guard<std::mutex> lock(m_controllers_mutex);
+    for (int i = 0; i < MAX_CONTROLLERS; i++)
+    {
+        if (m_controllers[i] == nullptr) continue;
+        if (SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(m_controllers[i])) != instance_id) continue;
+
+        SDL_GameControllerClose(m_controllers[i]);
+        m_controllers[i] = nullptr;
+    }
+}
+
+void ControllerSampler::run()
+{
+    const std::chrono::nanoseconds period(1000000000LL / m_sample_rate);
+    std::chrono::steady_clock::time_point next_sample = std::chrono::steady_clock::now();
+
+    Snapshot previous = {};
+    while (m_is_running)
+    {
+        // The main thread's event pump updates joysticks too, only once a frame; the lock keeps the two
+        // updates from overlapping. Hotplug found here still reaches the main thread as an event.
+        SDL_LockJoysticks();
+        SDL_JoystickUpdate();
+        SDL_UnlockJoysticks();
+
+        Snapshot snapshot = sample();
+
+        // Only changes are worth sending; an unchanged stick would just fill the ring
+        if (snapshot.serve || snapshot.toggle_ai ||
+            snapshot.paddle_direction != previous.paddle_direction ||
+            snapshot.right_paddle_direction != previous.right_paddle_direction)
+        {
+            if (publish(snapshot))
+            {
+                previous = snapshot;
+                m_is_serve_pending = false;
+                m_is_toggle_ai_pending = false;
+            }
+        }
+
+        // Sleeping to an absolute deadline keeps the rate steady however long a sample took
+        next_sample += period;
+        std::this_thread::sleep_until(next_sample);
+    }
+}
+
+ControllerSampler::Snapshot ControllerSampler::sample()
+{
+    Snapshot snapshot = {};
+    snapshot.timestamp = SDL_GetTicks();
+
+    bool is_serve_down = false,
+         is_toggle_ai_down = false;
+
+    std::lock_guard<std::mutex> lock(m_controllers_mutex);
+    if (SDL_GameController *first = m_controllers[0])
+    {
+        snapshot.paddle_direction = stick_direction(first, SDL_CONTROLLER_AXIS_LEFTY);
+        if (SDL_GameControllerGetButton(first, SDL_CONTROLLER_BUTTON_DPAD_UP))   snapshot.paddle_direction = 1;
+        if (SDL_GameControllerGetButton(first, SDL_CONTROLLER_BUTTON_DPAD_DOWN)) snapshot.paddle_direction = -1;
+        snapshot.right_paddle_direction = stick_direction(first, SDL_CONTROLLER_AXIS_RIGHTY);
+
+        is_serve_down = SDL_GameControllerGetButton(first, SDL_CONTROLLER_BUTTON_A) != 0;
+        is_toggle_ai_down = SDL_GameControllerGetButton(first, SDL_CONTROLLER_BUTTON_Y) != 0;
+    }
+    if (SDL_GameController *second = m_controllers[1])
+    {
+        int direction = stick_direction(second, SDL_CONTROLLER_AXIS_LEFTY);
+        if (direction != 0) snapshot.right_paddle_direction = direction;
+
+        is_serve_down = is_serve_down || SDL_GameControllerGetButton(second, SDL_CONTROLLER_BUTTON_A);
+    }
+
+    // Buttons are reported on the press only, so holding one down does not serve every tick
+    if (is_serve_down && !m_was_serve_down) m_is_serve_pending = true;
+    if (is_toggle_ai_down && !m_was_toggle_ai_down) m_is_toggle_ai_pending = true;
+    snapshot.serve = m_is_serve_pending;
+    snapshot.toggle_ai = m_is_toggle_ai_pending;
+    m_was_serve_down = is_serve_down;
+    m_was_toggle_ai_down = is_toggle_ai_down;
+
+    return snapshot;
+}
+
+bool ControllerSampler::publish(const Snapshot &snapshot)
+{
+    unsigned tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == CAPACITY) return false;
+
+    m_snapshots[tail & INDEX_MASK] = snapshot;
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    // Wakes the main loop if it is asleep waiting for events
+    SDL_Event wake_event = {};
+    wake_event.type = SDL_USEREVENT;
+    SDL_PushEvent(&wake_event);
+    return true;
+}
+
+void ControllerSampler::consume_until(Uint32 tick_end, MatchInput &input)
+{
+    unsigned head = m_head.load(std::memory_order_relaxed),
+             tail = m_tail.load(std::memory_order_acquire);
+
+    // As with keys, a direction held at any point during the tick counts for the whole tick
+    int paddle_direction = m_paddle_direction,
+        right_paddle_direction = m_right_paddle_direction;
+
+    while (head != tail && m_snapshots[head & INDEX_MASK].timestamp <= tick_end)
+    {
+        const Snapshot &snapshot = m_snapshots[head & INDEX_MASK];
+        head++;
+
+        m_paddle_direction = snapshot.paddle_direction;
+        m_right_paddle_direction = snapshot.right_paddle_direction;
+        if (m_paddle_direction != 0)       paddle_direction = m_paddle_direction;
+        if (m_right_paddle_direction != 0) right_paddle_direction = m_right_paddle_direction;
+
+        input.serve = input.serve || snapshot.serve;
+        input.toggle_ai = input.toggle_ai || snapshot.toggle_ai;
+    }
+    m_head.store(head, std::memory_order_release);
+
+    if (input.paddle_direction == 0)       input.paddle_direction = paddle_direction;
+    if (input.right_paddle_direction == 0) input.right_paddle_direction = right_paddle_direction;
+}
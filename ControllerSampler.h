@@ -0,0 +1,86 @@
+#pragma once
+
+#include <SDL.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "Match.h"
+
+// Reads game controllers on its own thread at a fixed rate and hands timestamped snapshots to the
+// simulation through a single-producer, single-consumer ring. Controllers can be plugged in and pulled
+// out at any time; the main thread opens and closes them as SDL reports it. The sampling thread updates
+// the joystick state itself before every sample, under SDL's joystick lock, so a sample sees the
+// controller as it is at that moment rather than as of the main thread's last event pump, once a frame.
+// The first controller's left stick or d-pad drives the left paddle and its right stick the right
+// paddle; a second controller's left stick takes over the right paddle.
+class ControllerSampler
+{
+private:
+    struct Snapshot
+    {
+        Uint32 timestamp;  // milliseconds, same clock as SDL_GetTicks()
+        int    paddle_direction;
+        int    right_paddle_direction;
+        bool   serve;      // A pressed since the previous snapshot
+        bool   toggle_ai;  // Y pressed since the previous snapshot
+    };
+
+    void run();
+    Snapshot sample();
+    bool publish(const Snapshot &snapshot);
+
+    static constexpr int MAX_CONTROLLERS = 2;
+
+    // A power of two so the ever-increasing indices can wrap with a mask
+    static constexpr unsigned CAPACITY = 256,
+                              INDEX_MASK = CAPACITY - 1;
+
+    // Opened and closed by the main thread, read by the sampling thread
+    SDL_GameController *m_controllers[MAX_CONTROLLERS];
+    std::mutex          m_controllers_mutex;
+
+    // Producer side, touched only by the sampling thread. A press stays pending until a snapshot
+    // carrying it makes it into the ring, so a full ring delays presses instead of losing them.
+    bool m_was_serve_down;
+    bool m_was_toggle_ai_down;
+    bool m_is_serve_pending;
+    bool m_is_toggle_ai_pending;
+
+    Snapshot              m_snapshots[CAPACITY];
+    std::atomic<unsigned> m_head;  // written by the consumer
+    std::atomic<unsigned> m_tail;  // written by the producer
+
+    // Consumer side: the directions of the last snapshot consumed
+    int m_paddle_direction;
+    int m_right_paddle_direction;
+
+    std::thread       m_thread;
+    std::atomic<bool> m_is_running;
+    int               m_sample_rate;
+
+public:
+    static constexpr int DEFAULT_SAMPLE_RATE = 1000;  // Hz
+
+    // Fraction of full stick travel ignored around the centre
+    static constexpr float STICK_DEAD_ZONE = 0.35f;
+
+    ControllerSampler();
+    ~ControllerSampler();
+
+    void start(int sample_rate = DEFAULT_SAMPLE_RATE);
+
+    // Also closes every controller, so call it before SDL shuts down
+    void stop();
+
+    // For SDL_CONTROLLERDEVICEADDED and SDL_CONTROLLERDEVICEREMOVED, on the thread that pumps events.
+    // Controllers beyond the first MAX_CONTROLLERS are ignored.
+    void add_controller(int device_index);
+    void remove_controller(SDL_JoystickID instance_id);
+
+    // Folds every snapshot stamped at or before tick_end into the keyboard input for that tick. The
+    // controller only steers a paddle the keyboard is leaving alone; serve and AI presses are added.
+    void consume_until(Uint32 tick_end, MatchInput &input);
+
+    bool const is_running()         const { return m_is_running; };
+    bool const is_any_stick_held() const { return m_paddle_direction != 0 || m_right_paddle_direction != 0; };
+};
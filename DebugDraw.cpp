@@ -0,0 +1,80 @@
+#define GL_SILENCE_DEPRECATION
+
+#include "DebugDraw.h"
+
+#ifdef DEBUG_DRAW_ENABLED
+
+#include <cmath>
+#include <cstring>
+
+uint32_t DebugDraw::pack_colour(const glm::vec4 &colour)
+{
+    uint8_t channels[4] = {
+        (uint8_t) (colour.r * 255.0f), (uint8_t) (colour.g * 255.0f),
+        (uint8_t) (colour.b * 255.0f), (uint8_t) (colour.a * 255.0f)
+    };
+    uint32_t packed_colour;
+    std::memcpy(&packed_colour, channels, sizeof(packed_colour));
+    return packed_colour;
+}
+
+void DebugDraw::line(const glm::vec3 &start, const glm::vec3 &end, const glm::vec4 &colour)
+{
+    uint32_t packed_colour = pack_colour(colour);
+    m_vertices.push_back({ start.x, start.y, packed_colour });
+    m_vertices.push_back({ end.x, end.y, packed_colour });
+}
+
+void DebugDraw::box(const glm::vec3 &centre, const glm::vec3 &half_extents, const glm::vec4 &colour)
+{
+    glm::vec3 bottom_left  = centre + glm::vec3(-half_extents.x, -half_extents.y, 0.0f),
+              bottom_right = centre + glm::vec3( half_extents.x, -half_extents.y, 0.0f),
+              top_right    = centre + glm::vec3( half_extents.x,  half_extents.y, 0.0f),
+              top_left     = centre + glm::vec3(-half_extents.x,  half_extents.y, 0.0f);
+
+    line(bottom_left, bottom_right, colour);
+    line(bottom_right, top_right, colour);
+    line(top_right, top_left, colour);
+    line(top_left, bottom_left, colour);
+}
+
+void DebugDraw::circle(const glm::vec3 &centre, float radius, const glm::vec4 &colour)
+{
+    constexpr float SEGMENT_ANGLE = 6.28318530718f / CIRCLE_SEGMENTS;
+
+    glm::vec3 previous = centre + glm::vec3(radius, 0.0f, 0.0f);
+    for (int i = 1; i <= CIRCLE_SEGMENTS; i++)
+    {
+        glm::vec3 next = centre + glm::vec3(std::cos(i * SEGMENT_ANGLE), std::sin(i * SEGMENT_ANGLE), 0.0f) * radius;
+        line(previous, next, colour);
+        previous = next;
+    }
+}
+
+void DebugDraw::path(const glm::vec3 *points, int point_count, const glm::vec4 &colour)
+{
+    for (int i = 1; i < point_count; i++) line(points[i - 1], points[i], colour);
+}
+
+void DebugDraw::flush(ShaderProgram &program)
+{
+    if (m_vertices.empty()) return;
+
+    GLuint colour_attribute = program.get_vertex_colour_attribute();
+
+    program.set_model_matrix(glm::mat4(1.0f));
+
+    glVertexAttribPointer(program.get_position_attribute(), 2, GL_FLOAT, false, sizeof(Vertex), &m_vertices[0].x);
+    glEnableVertexAttribArray(program.get_position_attribute());
+    glVertexAttribPointer(colour_attribute, 4, GL_UNSIGNED_BYTE, true, sizeof(Vertex), &m_vertices[0].colour);
+    glEnableVertexAttribArray(colour_attribute);
+
+    glDrawArrays(GL_LINES, 0, (GLsizei) m_vertices.size());
+
+    glDisableVertexAttribArray(program.get_position_attribute());
+    glDisableVertexAttribArray(colour_attribute);
+
+    m_vertices.clear();
+}
+
+#endif
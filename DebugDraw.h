@@ -0,0 +1,60 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <cstdint>
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "ShaderProgram.h"
+
+// Release builds (NDEBUG) compile every call below down to nothing
+#ifndef NDEBUG
+    #define DEBUG_DRAW_ENABLED 1
+#endif
+
+// Immediate-mode debug lines. Shapes are appended to one coloured vertex stream during the frame and
+// flush() draws the lot with a single GL_LINES call, then empties the stream.
+class DebugDraw
+{
+#ifdef DEBUG_DRAW_ENABLED
+private:
+    struct Vertex
+    {
+        float    x;
+        float    y;
+        uint32_t colour;
+    };
+
+    static uint32_t pack_colour(const glm::vec4 &colour);
+
+    std::vector<Vertex> m_vertices;
+
+public:
+    static constexpr int CIRCLE_SEGMENTS = 24;
+
+    void line(const glm::vec3 &start, const glm::vec3 &end, const glm::vec4 &colour);
+    void box(const glm::vec3 &centre, const glm::vec3 &half_extents, const glm::vec4 &colour);
+    void circle(const glm::vec3 &centre, float radius, const glm::vec4 &colour);
+    void path(const glm::vec3 *points, int point_count, const glm::vec4 &colour);
+
+    void flush(ShaderProgram &program);
+    void clear() { m_vertices.clear(); };
+
+    int const get_vertex_count() const { return (int) m_vertices.size(); };
+#else
+public:
+    void line(const glm::vec3 &, const glm::vec3 &, const glm::vec4 &)   {};
+    void box(const glm::vec3 &, const glm::vec3 &, const glm::vec4 &)    {};
+    void circle(const glm::vec3 &, float, const glm::vec4 &)             {};
+    void path(const glm::vec3 *, int, const glm::vec4 &)                 {};
+
+    void flush(ShaderProgram &) {};
+    void clear()                {};
+
+    int const get_vertex_count() const { return 0; };
+#endif
+};
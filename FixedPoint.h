@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+// Signed 16.16 fixed-point number. Every operation is plain integer arithmetic, so a simulation built
+// on it gives bit-identical results on any compiler, CPU and optimisation level. The range is roughly
+// +/-32768 with a resolution of 1/65536, which is plenty for a court ten units wide.
+struct Fixed
+{
+    int32_t raw;
+
+    static constexpr int32_t ONE = 1 << 16;
+
+    constexpr Fixed() : raw(0) {}
+
+    // Implicit so constants can be written as float literals; IEEE rounding of the literal is exact
+    // and identical everywhere, unlike float arithmetic
+    constexpr Fixed(float value) : raw((int32_t) (value * ONE + (value < 0.0f ? -0.5f : 0.5f))) {}
+
+    static constexpr Fixed from_raw(int32_t raw) { Fixed value; value.raw = raw; return value; }
+
+    Fixed &operator+=(Fixed other) { raw += other.raw; return *this; }
+    Fixed &operator-=(Fixed other) { raw -= other.raw; return *this; }
+    Fixed &operator*=(Fixed other) { raw = (int32_t) (((int64_t) raw * other.raw) >> 16); return *this; }
+    Fixed &operator/=(Fixed other) { raw = (int32_t) ((int64_t) raw * ONE / other.raw); return *this; }
+};
+
+constexpr Fixed operator+(Fixed a, Fixed b) { return Fixed::from_raw(a.raw + b.raw); }
+constexpr Fixed operator-(Fixed a, Fixed b) { return Fixed::from_raw(a.raw - b.raw); }
+constexpr Fixed operator-(Fixed a)          { return Fixed::from_raw(-a.raw); }
+constexpr Fixed operator*(Fixed a, Fixed b) { return Fixed::from_raw((int32_t) (((int64_t) a.raw * b.raw) >> 16)); }
+constexpr Fixed operator/(Fixed a, Fixed b) { return Fixed::from_raw((int32_t) ((int64_t) a.raw * Fixed::ONE / b.raw)); }
+
+constexpr bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+constexpr bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+constexpr bool operator< (Fixed a, Fixed b) { return a.raw <  b.raw; }
+constexpr bool operator> (Fixed a, Fixed b) { return a.raw >  b.raw; }
+constexpr bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+constexpr bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+// The few scalar helpers the simulation needs, overloaded so the same code compiles for float and Fixed
+inline float sim_abs(float value)  { return std::fabs(value); }
+inline Fixed sim_abs(Fixed value)  { return Fixed::from_raw(value.raw < 0 ? -value.raw : value.raw); }
+
+inline float to_float(float value) { return value; }
+inline float to_float(Fixed value) { return value.raw * (1.0f / Fixed::ONE); }
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cstdint>
+#include "FrameArena.h"
+
+namespace
+{
+    // Overflow and growth round up to this, so a frame that creeps up a few bytes at a time does not
+    // grow the block every frame
+    constexpr size_t GROWTH_GRANULE = 64 * 1024;
+
+    size_t round_up(size_t size, size_t granule) { return (size + granule - 1) / granule * granule; }
+
+    unsigned char *align(unsigned char *pointer, size_t alignment)
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+        return pointer + (round_up(address, alignment) - address);
+    }
+}
+
+FrameArena::FrameArena(size_t capacity) :
+    m_memory(capacity > 0 ? new unsigned char[capacity] : nullptr), m_capacity(capacity), m_used(0),
+    m_overflow_bytes(0), m_high_water_mark(0), m_grow_count(0)
+{
+}
+
+void *FrameArena::allocate(size_t size, size_t alignment)
+{
+    if (m_memory)
+    {
+        unsigned char *start = align(m_memory.get() + m_used, alignment);
+        size_t end = (size_t) (start - m_memory.get()) + size;
+        if (end <= m_capacity)
+        {
+            m_used = end;
+            return start;
+        }
+    }
+
+    // Too big for what is left: hand out a block of its own and count it towards the next growth
+    m_overflow.emplace_back(new unsigned char[size + alignment]);
+    m_overflow_bytes += size + alignment;
+    return align(m_overflow.back().get(), alignment);
+}
+
+void FrameArena::reset()
+{
+    m_high_water_mark = std::max(m_high_water_mark, get_used());
+
+    if (!m_overflow.empty())
+    {
+        m_overflow.clear();
+        m_capacity = round_up(std::max(m_high_water_mark, m_capacity + m_capacity / 2), GROWTH_GRANULE);
+        m_memory.reset(new unsigned char[m_capacity]);
+        m_grow_count++;
+    }
+
+    m_used = 0;
+    m_overflow_bytes = 0;
+}
+
+void FrameArena::reserve(size_t capacity)
+{
+    reset();
+    if (capacity <= m_capacity) return;
+
+    m_capacity = capacity;
+    m_memory.reset(new unsigned char[m_capacity]);
+}
+
+DoubleFrameArena::DoubleFrameArena(size_t capacity) : m_current(0)
+{
+    for (FrameArena &arena : m_arenas) arena.reserve(capacity);
+}
+
+void DoubleFrameArena::end_frame()
+{
+    m_current = 1 - m_current;
+    m_arenas[m_current].reset();
+}
+
+size_t const DoubleFrameArena::get_high_water_mark() const
+{
+    return std::max(m_arenas[0].get_high_water_mark(), m_arenas[1].get_high_water_mark());
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame: allocating moves an offset along
+// one block, and reset() takes the whole frame's worth back at once. Nothing is freed individually.
+// A frame that needs more than the block holds still gets its memory, from the general heap, and the
+// next reset() grows the block to the most any frame has used, so a steady run settles into no heap
+// allocations at all.
+class FrameArena
+{
+private:
+    std::unique_ptr<unsigned char[]> m_memory;
+    size_t m_capacity;
+    size_t m_used;
+
+    // Allocations that did not fit this frame; freed by reset()
+    std::vector<std::unique_ptr<unsigned char[]>> m_overflow;
+    size_t m_overflow_bytes;
+
+    size_t m_high_water_mark;  // most bytes any one frame has asked for, overflow included
+    int    m_grow_count;
+
+public:
+    explicit FrameArena(size_t capacity = 0);
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Uninitialised room for count objects; meant for plain data that needs no destructor
+    template <typename T>
+    T *allocate_array(size_t count) { return static_cast<T *>(allocate(count * sizeof(T), alignof(T))); };
+
+    // Everything allocated since the last reset() becomes invalid
+    void reset();
+
+    // Makes the block at least this big; also invalidates everything, so only call it between frames
+    void reserve(size_t capacity);
+
+    size_t const get_used()            const { return m_used + m_overflow_bytes; };
+    size_t const get_capacity()        const { return m_capacity;               };
+    size_t const get_high_water_mark() const { return m_high_water_mark;        };
+    int    const get_grow_count()      const { return m_grow_count;             };
+};
+
+// Two arenas taking turns a frame at a time. Whatever one frame allocates stays valid through the next,
+// long enough for another thread to consume it (a render thread drawing the frame just built) while the
+// next frame is being built in the other arena.
+class DoubleFrameArena
+{
+private:
+    FrameArena m_arenas[2];
+    int        m_current;
+
+public:
+    explicit DoubleFrameArena(size_t capacity = 0);
+
+    // Moves to the other arena and empties it; call once at the end of every frame
+    void end_frame();
+
+    FrameArena &get_current()  { return m_arenas[m_current];     };
+    FrameArena &get_previous() { return m_arenas[1 - m_current]; };
+
+    size_t const get_high_water_mark() const;
+    int    const get_grow_count()      const { return m_arenas[0].get_grow_count() + m_arenas[1].get_grow_count(); };
+};
+
+// Lets standard containers take their memory from a frame arena. deallocate() does nothing, so a
+// growing container leaves its old buffers behind until the reset; reserve() the final size up front.
+template <typename T>
+class FrameAllocator
+{
+private:
+    FrameArena *m_arena;
+
+public:
+    typedef T value_type;
+
+    explicit FrameAllocator(FrameArena &arena) : m_arena(&arena) {}
+
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U> &other) : m_arena(other.get_arena()) {}
+
+    T *allocate(size_t count) { return m_arena->allocate_array<T>(count); };
+    void deallocate(T *, size_t) {}
+
+    FrameArena *get_arena() const { return m_arena; };
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T> &a, const FrameAllocator<U> &b) { return a.get_arena() == b.get_arena(); }
+
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T> &a, const FrameAllocator<U> &b) { return a.get_arena() != b.get_arena(); }
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include "InputLog.h"
+
+namespace
+{
+    const char MAGIC[4] = { 'T', 'N', 'I', 'L' },
+               INDEX_MAGIC[4] = { 'X', 'D', 'N', 'I' };
+    constexpr size_t HEADER_SIZE = 20,
+                     KEYFRAME_HEADER_SIZE = 7,  // marker, tick, size
+                     TRAILER_SIZE = 20;
+
+    // Bits 0-1 left paddle, 2-3 right paddle (0 still, 1 up, 2 down), bit 4 AI toggle, bit 5 serve
+    uint8_t pack_direction(int direction) { return direction > 0 ? 1 : direction < 0 ? 2 : 0; }
+    int unpack_direction(uint8_t bits)    { return bits == 1 ? 1 : bits == 2 ? -1 : 0; }
+
+    uint8_t pack_input(const MatchInput &input)
+    {
+        return (uint8_t) (pack_direction(input.paddle_direction) |
+                          pack_direction(input.right_paddle_direction) << 2 |
+                          (input.toggle_ai ? 1 << 4 : 0) |
+                          (input.serve ? 1 << 5 : 0));
+    }
+
+    MatchInput unpack_input(uint8_t packed)
+    {
+        MatchInput input;
+        input.paddle_direction = unpack_direction(packed & 3);
+        input.right_paddle_direction = unpack_direction(packed >> 2 & 3);
+        input.toggle_ai = (packed & 1 << 4) != 0;
+        input.serve = (packed & 1 << 5) != 0;
+        return input;
+    }
+
+    void put_u16(std::vector<uint8_t> &bytes, uint16_t value)
+    {
+        bytes.push_back((uint8_t) value);
+        bytes.push_back((uint8_t) (value >> 8));
+    }
+
+    void put_u32(std::vector<uint8_t> &bytes, uint32_t value)
+    {
+        for (int shift = 0; shift < 32; shift += 8) bytes.push_back((uint8_t) (value >> shift));
+    }
+
+    uint16_t get_u16(const uint8_t *bytes) { return (uint16_t) (bytes[0] | bytes[1] << 8); }
+    uint32_t get_u32(const uint8_t *bytes) { return (uint32_t) get_u16(bytes) | (uint32_t) get_u16(bytes + 2) << 16; }
+
+    // Zero bytes (idle movement, z components, small integers) are common in a match, anything else is
+    // close to random, so packing zero runs is nearly all the compression a keyframe can get cheaply
+    std::vector<uint8_t> pack_zero_runs(const uint8_t *bytes, size_t size)
+    {
+        std::vector<uint8_t> packed;
+        for (size_t i = 0; i < size; )
+        {
+            packed.push_back(bytes[i]);
+            if (bytes[i++] != 0) continue;
+
+            uint8_t run = 1;
+            while (i < size && bytes[i] == 0 && run < 255) { run++; i++; }
+            packed.push_back(run);
+        }
+        return packed;
+    }
+
+    bool unpack_zero_runs(const uint8_t *packed, size_t packed_size, uint8_t *bytes, size_t size)
+    {
+        size_t written = 0;
+        for (size_t i = 0; i < packed_size; i++)
+        {
+            if (packed[i] != 0)
+            {
+                if (written >= size) return false;
+                bytes[written++] = packed[i];
+                continue;
+            }
+
+            if (++i >= packed_size || written + packed[i] > size) return false;
+            std::fill(bytes + written, bytes + written + packed[i], 0);
+            written += packed[i];
+        }
+        return written == size;
+    }
+
+    uint32_t fnv1a(uint32_t hash, const void *data, size_t size)
+    {
+        const uint8_t *bytes = (const uint8_t *) data;
+        for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 16777619u;
+        return hash;
+    }
+}
+
+uint32_t simulation_build_hash()
+{
+    const float constants[] = {
+        COURT_HALF_WIDTH, WALL_Y, PADDLE_TRAVEL_TOP, PADDLE_TRAVEL_LENGTH, BALL_SPEED_GROWTH,
+        INIT_BALL_SPEED, POINT_PAUSE_DURATION, (float) POINTS_TO_WIN,
+        INIT_PLAYER_1_SCALE.x, INIT_PLAYER_1_SCALE.y, INIT_PLAYER_2_SCALE.x, INIT_PLAYER_2_SCALE.y,
+        INIT_BALL_SCALE.x, INIT_BALL_SCALE.y
+    };
+    const uint32_t match_size = (uint32_t) sizeof(Match),
+                   is_fixed_point = std::is_same<SimScalar, Fixed>::value;
+
+    uint32_t hash = 2166136261u;
+    hash = fnv1a(hash, constants, sizeof(constants));
+    hash = fnv1a(hash, &match_size, sizeof(match_size));
+    hash = fnv1a(hash, &is_fixed_point, sizeof(is_fixed_point));
+
+    // Different compilers are free to round float expressions differently
+#if defined(_MSC_VER)
+    const long compiler = _MSC_VER;
+#elif defined(__clang__)
+    const long compiler = 100000L + __clang_major__ * 100 + __clang_minor__;
+#elif defined(__GNUC__)
+    const long compiler = 200000L + __GNUC__ * 100 + __GNUC_MINOR__;
+#else
+    const long compiler = 0;
+#endif
+    return fnv1a(hash, &compiler, sizeof(compiler));
+}
+
+InputLogWriter::InputLogWriter() :
+    m_size(0), m_match_count(0), m_run_input(0), m_run_focus(0), m_run_length(0), m_tick(0)
+{
+}
+
+InputLogWriter::~InputLogWriter()
+{
+    close();
+}
+
+bool InputLogWriter::open(const char *filepath, const InputLogHeader &header)
+{
+    m_file.open(filepath, std::ios::binary | std::ios::trunc);
+    if (!m_file)
+    {
+        std::cout << "Unable to create input log " << filepath << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> bytes(MAGIC, MAGIC + 4);
+    put_u16(bytes, header.version);
+    put_u16(bytes, header.match_count);
+    put_u32(bytes, header.seed);
+    put_u32(bytes, header.build_hash);
+    put_u32(bytes, header.tick_ms);
+
+    m_size = 0;
+    write(bytes.data(), bytes.size());
+
+    m_match_count = header.match_count;
+    m_run_length = 0;
+    m_tick = 0;
+    m_keyframes.clear();
+    return true;
+}
+
+void InputLogWriter::write(const uint8_t *bytes, size_t size)
+{
+    m_file.write((const char *) bytes, size);
+    m_size += (uint32_t) size;
+}
+
+void InputLogWriter::record(const MatchInput &input, int focused_match, const Match *matches)
+{
+    if (!m_file.is_open()) return;
+
+    if (m_tick % KEYFRAME_INTERVAL_TICKS == 0 && matches != nullptr)
+    {
+        // Runs never straddle a keyframe, so a reader can start cleanly right after one
+        if (m_run_length > 0) write_run();
+        write_keyframe(matches);
+    }
+    m_tick++;
+
+    uint8_t packed = pack_input(input),
+            focus = (uint8_t) focused_match;
+
+    if (m_run_length > 0 && (packed != m_run_input || focus != m_run_focus)) write_run();
+
+    m_run_input = packed;
+    m_run_focus = focus;
+    m_run_length++;
+}
+
+void InputLogWriter::write_run()
+{
+    uint8_t bytes[7];
+    int size = 0;
+
+    uint32_t length = m_run_length;
+    do
+    {
+        bytes[size++] = (uint8_t) ((length & 0x7F) | (length > 0x7F ? 0x80 : 0));
+        length >>= 7;
+    } while (length > 0);
+    bytes[size++] = m_run_input;
+    bytes[size++] = m_run_focus;
+
+    write(bytes, size);
+    m_run_length = 0;
+}
+
+void InputLogWriter::write_keyframe(const Match *matches)
+{
+    std::vector<uint8_t> packed = pack_zero_runs((const uint8_t *) matches, m_match_count * sizeof(Match));
+
+    m_keyframes.push_back({ m_tick, m_size });
+
+    std::vector<uint8_t> bytes(1, 0);
+    put_u32(bytes, m_tick);
+    put_u16(bytes, (uint16_t) packed.size());
+    write(bytes.data(), bytes.size());
+    write(packed.data(), packed.size());
+}
+
+void InputLogWriter::close()
+{
+    if (!m_file.is_open()) return;
+
+    if (m_run_length > 0) write_run();
+
+    std::vector<uint8_t> bytes;
+    for (const InputLogKeyframe &keyframe : m_keyframes)
+    {
+        put_u32(bytes, keyframe.tick);
+        put_u32(bytes, keyframe.offset);
+    }
+    put_u32(bytes, m_size);
+    put_u32(bytes, (uint32_t) m_keyframes.size());
+    put_u32(bytes, m_tick);
+    put_u32(bytes, KEYFRAME_INTERVAL_TICKS);
+    bytes.insert(bytes.end(), INDEX_MAGIC, INDEX_MAGIC + 4);
+    write(bytes.data(), bytes.size());
+
+    m_file.close();
+}
+
+InputLogReader::InputLogReader() :
+    m_offset(0), m_records_end(0), m_run_input(0), m_run_focus(0), m_run_left(0),
+    m_tick(0), m_tick_count(0), m_keyframe_interval(0)
+{
+}
+
+bool InputLogReader::load(const char *filepath)
+{
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Unable to open input log " << filepath << std::endl;
+        return false;
+    }
+
+    m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_offset = m_data.size();
+    m_records_end = m_data.size();
+    m_run_left = 0;
+    m_tick = 0;
+    m_keyframes.clear();
+
+    if (m_data.size() < HEADER_SIZE || !std::equal(MAGIC, MAGIC + 4, m_data.begin()))
+    {
+        std::cout << filepath << " is not an input log" << std::endl;
+        return false;
+    }
+
+    m_header.version = get_u16(&m_data[4]);
+    m_header.match_count = get_u16(&m_data[6]);
+    m_header.seed = get_u32(&m_data[8]);
+    m_header.build_hash = get_u32(&m_data[12]);
+    m_header.tick_ms = get_u32(&m_data[16]);
+
+    // Version 1 is version 2 without keyframes or index, so it still plays; it just cannot seek
+    if (m_header.version < 1 || m_header.version > InputLogHeader().version)
+    {
+        std::cout << filepath << " uses unsupported input log version " << m_header.version << std::endl;
+        return false;
+    }
+
+    if (!read_index()) scan_records();
+
+    m_offset = HEADER_SIZE;
+    return true;
+}
+
+bool InputLogReader::read_index()
+{
+    if (m_data.size() < HEADER_SIZE + TRAILER_SIZE) return false;
+
+    const uint8_t *trailer = &m_data[m_data.size() - TRAILER_SIZE];
+    if (!std::equal(INDEX_MAGIC, INDEX_MAGIC + 4, trailer + 16)) return false;
+
+    uint32_t index_offset = get_u32(trailer),
+             keyframe_count = get_u32(trailer + 4);
+    if (index_offset < HEADER_SIZE || (size_t) index_offset + keyframe_count * 8ull + TRAILER_SIZE != m_data.size()) return false;
+
+    m_keyframes.resize(keyframe_count);
+    for (uint32_t i = 0; i < keyframe_count; i++)
+    {
+        m_keyframes[i].tick = get_u32(&m_data[index_offset + i * 8]);
+        m_keyframes[i].offset = get_u32(&m_data[index_offset + i * 8 + 4]);
+    }
+
+    m_records_end = index_offset;
+    m_tick_count = get_u32(trailer + 8);
+    m_keyframe_interval = get_u32(trailer + 12);
+    return true;
+}
+
+void InputLogReader::scan_records()
+{
+    m_offset = HEADER_SIZE;
+    m_tick_count = 0;
+    while (m_offset < m_records_end)
+    {
+        size_t record_offset = m_offset;
+        if (m_data[m_offset] == 0 && m_offset + KEYFRAME_HEADER_SIZE <= m_records_end)
+        {
+            m_keyframes.push_back({ get_u32(&m_data[m_offset + 1]), (uint32_t) record_offset });
+        }
+        if (read_run()) m_tick_count += m_run_left;
+    }
+
+    m_run_left = 0;
+    m_keyframe_interval = m_keyframes.size() > 1 ? m_keyframes[1].tick - m_keyframes[0].tick : 0;
+}
+
+bool InputLogReader::read_run()
+{
+    if (m_data[m_offset] == 0)
+    {
+        // Playback already has the state a keyframe holds, so it only needs stepping over
+        size_t size = m_offset + KEYFRAME_HEADER_SIZE <= m_records_end ? get_u16(&m_data[m_offset + 5]) : 0;
+        m_offset = std::min(m_offset + KEYFRAME_HEADER_SIZE + size, m_records_end);
+        return false;
+    }
+
+    uint32_t length = 0;
+    for (int shift = 0; m_offset < m_data.size() && shift < 35; shift += 7)
+    {
+        uint8_t byte = m_data[m_offset++];
+        length |= (uint32_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+
+    if (m_offset + 2 > m_records_end)
+    {
+        // A truncated record (say, from a crash mid-write) ends the replay
+        m_offset = m_records_end;
+        return false;
+    }
+
+    m_run_input = m_data[m_offset++];
+    m_run_focus = m_data[m_offset++];
+    m_run_left = length;
+    return length > 0;
+}
+
+bool InputLogReader::next(MatchInput &input, int &focused_match)
+{
+    while (m_run_left == 0)
+    {
+        if (m_offset >= m_records_end) return false;
+        read_run();
+    }
+
+    m_run_left--;
+    m_tick++;
+    input = unpack_input(m_run_input);
+    focused_match = m_run_focus;
+    return true;
+}
+
+bool InputLogReader::unpack_keyframe(size_t offset, Match *matches) const
+{
+    if (offset + KEYFRAME_HEADER_SIZE > m_records_end || m_data[offset] != 0) return false;
+
+    size_t packed_size = get_u16(&m_data[offset + 5]);
+    if (offset + KEYFRAME_HEADER_SIZE + packed_size > m_records_end) return false;
+
+    return unpack_zero_runs(&m_data[offset + KEYFRAME_HEADER_SIZE], packed_size,
+                            (uint8_t *) matches, m_header.match_count * sizeof(Match));
+}
+
+bool InputLogReader::seek(uint32_t tick, Match *matches)
+{
+    if (m_keyframes.empty()) return false;
+    tick = std::min(tick, m_tick_count);
+
+    // Keyframes are evenly spaced, so the right one is a division away; the loop only runs for a
+    // shorter than usual interval, such as one cut short by a crash
+    size_t index = m_keyframe_interval > 0 ? std::min((size_t) (tick / m_keyframe_interval), m_keyframes.size() - 1) : 0;
+    while (index > 0 && m_keyframes[index].tick > tick) index--;
+    while (index + 1 < m_keyframes.size() && m_keyframes[index + 1].tick <= tick) index++;
+
+    const InputLogKeyframe &keyframe = m_keyframes[index];
+    if (keyframe.tick > tick || !unpack_keyframe(keyframe.offset, matches))
+    {
+        std::cout << "Input log keyframe at tick " << keyframe.tick << " is damaged" << std::endl;
+        return false;
+    }
+
+    m_offset = keyframe.offset;
+    m_run_left = 0;
+    m_tick = keyframe.tick;
+
+    // Same stepping as live play: the focused match takes the input, the rest idle
+    const MatchInput idle_input;
+    const float delta_time = m_header.tick_ms / 1000.0f;
+    MatchInput input;
+    int focused_match;
+    while (m_tick < tick && next(input, focused_match))
+    {
+        for (int i = 0; i < m_header.match_count; i++)
+        {
+            update_match(matches[i], i == focused_match ? input : idle_input, delta_time);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+#include "Match.h"
+
+// Binary log of the input fed to every simulation tick, enough to replay a session exactly.
+//
+// Layout, all integers little-endian:
+//   header    "TNIL", u16 version, u16 match count, u32 seed, u32 build hash, u32 tick length in ms
+//   records   varint run length, u8 packed input, u8 focused match
+//   keyframe  varint 0, u32 tick, u16 size, every match's state as it was before that tick, with runs
+//             of zero bytes packed as a zero and a count
+//   index     u32 tick and u32 file offset of each keyframe
+//   trailer   u32 index offset, u32 keyframe count, u32 tick count, u32 keyframe interval, "XDNI"
+// Each record stands for that many consecutive ticks with identical input, so idle stretches cost a
+// few bytes however long they last. Keyframes (version 2 on) let a reader jump to any tick by restoring
+// the keyframe at or before it and simulating the rest of the way. A log cut short by a crash has no
+// index; the reader rebuilds it by scanning the records.
+struct InputLogHeader
+{
+    uint16_t version = 2;
+    uint16_t match_count = 1;
+    uint32_t seed = 0;
+    uint32_t build_hash = 0;
+    uint32_t tick_ms = 0;
+};
+
+// Changes whenever a constant or layout that steers the simulation does, so a replay recorded by a
+// different build can be recognised (it may still play, but is not guaranteed to match)
+uint32_t simulation_build_hash();
+
+struct InputLogKeyframe
+{
+    uint32_t tick;
+    uint32_t offset;  // of the keyframe record in the file
+};
+
+class InputLogWriter
+{
+private:
+    void write(const uint8_t *bytes, size_t size);
+    void write_run();
+    void write_keyframe(const Match *matches);
+
+    std::ofstream m_file;
+    uint32_t      m_size;
+    int           m_match_count;
+
+    uint8_t  m_run_input;
+    uint8_t  m_run_focus;
+    uint32_t m_run_length;
+
+    uint32_t m_tick;
+    std::vector<InputLogKeyframe> m_keyframes;
+
+public:
+    // 4 seconds at the usual tick length: a seek never simulates more than this, and a minute of one
+    // match spends about 1.5 KB on keyframes
+    static constexpr uint32_t KEYFRAME_INTERVAL_TICKS = 500;
+
+    InputLogWriter();
+    ~InputLogWriter();
+
+    bool open(const char *filepath, const InputLogHeader &header);
+
+    // matches holds every match's state before this tick's input is applied; it is only read on ticks
+    // that get a keyframe
+    void record(const MatchInput &input, int focused_match, const Match *matches);
+    void close();
+
+    bool const is_open() const { return m_file.is_open(); };
+};
+
+class InputLogReader
+{
+private:
+    bool read_run();
+    bool read_index();
+    void scan_records();
+    bool unpack_keyframe(size_t offset, Match *matches) const;
+
+    std::vector<uint8_t> m_data;
+    size_t               m_offset;
+    size_t               m_records_end;
+    InputLogHeader       m_header;
+
+    uint8_t  m_run_input;
+    uint8_t  m_run_focus;
+    uint32_t m_run_left;
+
+    uint32_t m_tick;  // of the next input next() will produce
+    uint32_t m_tick_count;
+    uint32_t m_keyframe_interval;
+    std::vector<InputLogKeyframe> m_keyframes;
+
+public:
+    InputLogReader();
+
+    bool load(const char *filepath);
+
+    // Produces the input for the next tick; returns false once the log is exhausted
+    bool next(MatchInput &input, int &focused_match);
+
+    // Puts every match in the state it had before the given tick, which next() then produces. Finds the
+    // keyframe straight from the index, so the cost is bounded by the keyframe interval whatever the
+    // distance, backwards included. Returns false for logs without keyframes.
+    bool seek(uint32_t tick, Match *matches);
+
+    bool     const is_playing()     const { return m_run_left > 0 || m_offset < m_records_end; };
+    bool     const can_seek()       const { return !m_keyframes.empty(); };
+    uint32_t const get_tick()       const { return m_tick;               };
+    uint32_t const get_tick_count() const { return m_tick_count;         };
+    const InputLogHeader &get_header() const { return m_header; };
+};
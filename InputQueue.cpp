@@ -0,0 +1,77 @@
+#include "InputQueue.h"
+
+InputQueue::InputQueue() : m_head(0), m_tail(0)
+{
+    for (int key = 0; key < PADDLE_KEY_COUNT; key++) m_is_held[key] = false;
+}
+
+int InputQueue::paddle_key(SDL_Scancode scancode)
+{
+    switch (scancode)
+    {
+    case SDL_SCANCODE_W:    return LEFT_UP;
+    case SDL_SCANCODE_S:    return LEFT_DOWN;
+    case SDL_SCANCODE_UP:   return RIGHT_UP;
+    case SDL_SCANCODE_DOWN: return RIGHT_DOWN;
+    default:                return -1;
+    }
+}
+
+bool InputQueue::push(const SDL_KeyboardEvent &event)
+{
+    SDL_Scancode scancode = event.keysym.scancode;
+
+    if (event.repeat) return true;
+    if (paddle_key(scancode) < 0 && scancode != SDL_SCANCODE_T && scancode != SDL_SCANCODE_P) return true;
+    if (m_tail - m_head == CAPACITY) return false;
+
+    m_events[m_tail & INDEX_MASK] = { event.timestamp, scancode, event.state == SDL_PRESSED };
+    m_tail++;
+    return true;
+}
+
+MatchInput InputQueue::consume_until(Uint32 tick_end)
+{
+    MatchInput input;
+
+    bool was_down[PADDLE_KEY_COUNT];
+    for (int key = 0; key < PADDLE_KEY_COUNT; key++) was_down[key] = m_is_held[key];
+
+    while (m_head != m_tail && m_events[m_head & INDEX_MASK].timestamp <= tick_end)
+    {
+        const InputEvent &event = m_events[m_head & INDEX_MASK];
+        m_head++;
+
+        if (event.scancode == SDL_SCANCODE_T)
+        {
+            input.toggle_ai = input.toggle_ai || event.is_pressed;
+            continue;
+        }
+        if (event.scancode == SDL_SCANCODE_P)
+        {
+            input.serve = input.serve || event.is_pressed;
+            continue;
+        }
+
+        int key = paddle_key(event.scancode);
+        m_is_held[key] = event.is_pressed;
+        was_down[key] = was_down[key] || event.is_pressed;
+    }
+
+    // Same precedence as reading the keyboard state: down wins over up when both are held
+    if (was_down[LEFT_UP])    input.paddle_direction = 1;
+    if (was_down[LEFT_DOWN])  input.paddle_direction = -1;
+    if (was_down[RIGHT_UP])   input.right_paddle_direction = 1;
+    if (was_down[RIGHT_DOWN]) input.right_paddle_direction = -1;
+
+    return input;
+}
+
+bool InputQueue::is_any_key_held() const
+{
+    for (int key = 0; key < PADDLE_KEY_COUNT; key++)
+    {
+        if (m_is_held[key]) return true;
+    }
+    return false;
+}
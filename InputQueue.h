@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SDL.h>
+#include "Match.h"
+
+// Keyboard events meant for the simulation, kept in arrival order with their SDL timestamps so each
+// press and release is applied on the fixed tick it happened in rather than at the next frame boundary
+class InputQueue
+{
+private:
+    enum PaddleKey { LEFT_UP, LEFT_DOWN, RIGHT_UP, RIGHT_DOWN, PADDLE_KEY_COUNT };
+
+    struct InputEvent
+    {
+        Uint32       timestamp;  // milliseconds, same clock as SDL_GetTicks()
+        SDL_Scancode scancode;
+        bool         is_pressed;
+    };
+
+    static int paddle_key(SDL_Scancode scancode);
+
+    // A power of two so the ever-increasing indices can wrap with a mask
+    static constexpr unsigned CAPACITY = 256,
+                              INDEX_MASK = CAPACITY - 1;
+
+    InputEvent m_events[CAPACITY];
+    unsigned   m_head;  // next event to consume
+    unsigned   m_tail;  // next free slot
+
+    bool m_is_held[PADDLE_KEY_COUNT];
+
+public:
+    InputQueue();
+
+    // Ignores key repeats and keys the simulation does not use; returns false if the queue was full
+    bool push(const SDL_KeyboardEvent &event);
+
+    // Consumes every event stamped at or before tick_end and returns the input for the tick ending there.
+    // A paddle key pressed at any point during the tick counts for the whole tick, so a tap shorter than
+    // one tick still moves the paddle.
+    MatchInput consume_until(Uint32 tick_end);
+
+    bool const is_empty()        const { return m_head == m_tail; };
+    bool is_any_key_held() const;
+};
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <cmath>
+#include "ContactQueue.h"
+#include "Match.h"
+#include "PaddleAi.h"
+
+namespace
+{
+    // How far through the step a gap of `before` closed to `after`; 0 if there was no gap to begin with
+    float closing_fraction(float before, float after)
+    {
+        if (before <= 0.0f || after >= before) return 0.0f;
+        return std::min(before / (before - after), 1.0f);
+    }
+
+    void add_contact(Contact *contacts, int &count, int max_contacts, ContactType type, int match_index,
+                     int normal_x, int normal_y, float time_of_impact)
+    {
+        if (count >= max_contacts) return;
+        contacts[count++] = { time_of_impact, (uint16_t) match_index, (uint8_t) type, (int8_t) normal_x, (int8_t) normal_y };
+    }
+}
+
+template <typename Scalar>
+int update_match(BasicMatch<Scalar> &match, const MatchInput &input, float delta_time,
+                 ContactQueue *contacts, int match_index)
+{
+    typedef typename BasicMatch<Scalar>::Vec3 Vec3;
+
+    int events = MATCH_EVENT_NONE;
+    const Scalar step = delta_time;
+    const Scalar zero = 0.0f;
+
+    /* INPUT */
+    if (input.toggle_ai) match.right_paddle_swtich *= -1;
+
+    // The AI plans whenever the ball's path changes, or it takes over with a ball already in play
+    bool is_path_new = input.toggle_ai && match.right_paddle_swtich != -1;
+
+    /* PHASE */
+    switch (match.phase)
+    {
+    case PHASE_MATCH_OVER:
+        if (input.serve) reset_match(match);
+        return events;
+
+    case PHASE_POINT_SCORED:
+        match.phase_timer -= step;
+        if (match.phase_timer <= zero) reset_round(match);
+        return events;
+
+    case PHASE_SERVE:
+        if (input.serve)
+        {
+            match.ball_movement.x = match.serve_direction;
+            match.phase = PHASE_RALLY;
+            is_path_new = true;
+        }
+        break;
+
+    case PHASE_RALLY:
+        break;
+    }
+
+    match.paddle_movement = Vec3(zero);
+    match.right_paddle_movement = Vec3(zero);
+
+    if (input.paddle_direction > 0 && match.paddle_y_distance > zero) match.paddle_movement.y = 1.0f;
+    if (input.paddle_direction < 0 && match.paddle_y_distance < Scalar(PADDLE_TRAVEL_LENGTH)) match.paddle_movement.y = -1.0f;
+
+    if (input.right_paddle_direction > 0 && match.paddle_right_y_distance > zero) match.right_paddle_movement.y = 1.0f;
+    if (input.right_paddle_direction < 0 && match.paddle_right_y_distance < Scalar(PADDLE_TRAVEL_LENGTH)) match.right_paddle_movement.y = -1.0f;
+
+    /* GAME LOGIC */
+    match.ball_position += match.ball_movement * match.ball_speed * step;
+    match.paddle_position += match.paddle_movement * match.paddle_speed * step;
+    if (match.right_paddle_swtich == -1) {
+        match.right_paddle_position += match.right_paddle_movement * match.paddle_speed * step;
+    }
+    else {
+        steer_ai_paddle(match, step);
+    }
+
+    /* DISTANCE CALCULATIONS */
+    match.paddle_y_distance = Scalar(PADDLE_TRAVEL_TOP) - match.paddle_position.y;
+    match.paddle_right_y_distance = Scalar(PADDLE_TRAVEL_TOP) - match.right_paddle_position.y;
+    match.paddle_ball_x_distance = sim_abs(match.ball_position.x - match.paddle_position.x) - Scalar((INIT_BALL_SCALE.x + INIT_PLAYER_1_SCALE.x) / 2);
+    match.paddle_ball_y_distance = sim_abs(match.ball_position.y - match.paddle_position.y) - Scalar((INIT_BALL_SCALE.y + INIT_PLAYER_1_SCALE.y) / 2);
+    match.right_paddle_ball_x_distance = sim_abs(match.ball_position.x - match.right_paddle_position.x) - Scalar((INIT_BALL_SCALE.x + INIT_PLAYER_2_SCALE.x) / 2);
+    match.right_paddle_ball_y_distance = sim_abs(match.ball_position.y - match.right_paddle_position.y) - Scalar((INIT_BALL_SCALE.y + INIT_PLAYER_2_SCALE.y) / 2);
+
+    /* COLLISIONS: everything the ball touches is found before any of it is responded to */
+    Contact step_contacts[MAX_CONTACTS_PER_STEP];
+    int contact_count = detect_contacts(match, delta_time, match_index, step_contacts, MAX_CONTACTS_PER_STEP);
+    events |= resolve_contacts(match, step_contacts, contact_count);
+    if (contacts != nullptr) contacts->push(step_contacts, contact_count);
+
+    if (events & (MATCH_EVENT_LEFT_PADDLE_HIT | MATCH_EVENT_RIGHT_PADDLE_HIT)) is_path_new = true;
+
+    if (is_path_new && match.right_paddle_swtich != -1 && match.phase == PHASE_RALLY) plan_ai_intercept(match);
+
+    return events;
+}
+
+template <typename Scalar>
+int detect_contacts(const BasicMatch<Scalar> &match, float delta_time, int match_index, Contact *contacts, int max_contacts)
+{
+    const Scalar zero = 0.0f;
+    int count = 0;
+
+    // Times of impact come from where the ball was at the start of the step, against the paddles where
+    // they are now. They only describe the contact; the simulation never reads them back.
+    glm::vec3 ball = to_vec3(match.ball_position),
+              previous_ball = ball - to_vec3(match.ball_movement) * to_float(match.ball_speed) * delta_time;
+
+    if (match.paddle_ball_x_distance <= zero && match.paddle_ball_y_distance <= zero)
+    {
+        glm::vec3 paddle = to_vec3(match.paddle_position);
+        float time_x = closing_fraction(std::fabs(previous_ball.x - paddle.x) - (INIT_BALL_SCALE.x + INIT_PLAYER_1_SCALE.x) / 2,
+                                        to_float(match.paddle_ball_x_distance)),
+              time_y = closing_fraction(std::fabs(previous_ball.y - paddle.y) - (INIT_BALL_SCALE.y + INIT_PLAYER_1_SCALE.y) / 2,
+                                        to_float(match.paddle_ball_y_distance));
+        add_contact(contacts, count, max_contacts, CONTACT_LEFT_PADDLE, match_index, 1, 0, std::max(time_x, time_y));
+    }
+    if (match.right_paddle_ball_x_distance <= zero && match.right_paddle_ball_y_distance <= zero)
+    {
+        glm::vec3 paddle = to_vec3(match.right_paddle_position);
+        float time_x = closing_fraction(std::fabs(previous_ball.x - paddle.x) - (INIT_BALL_SCALE.x + INIT_PLAYER_2_SCALE.x) / 2,
+                                        to_float(match.right_paddle_ball_x_distance)),
+              time_y = closing_fraction(std::fabs(previous_ball.y - paddle.y) - (INIT_BALL_SCALE.y + INIT_PLAYER_2_SCALE.y) / 2,
+                                        to_float(match.right_paddle_ball_y_distance));
+        add_contact(contacts, count, max_contacts, CONTACT_RIGHT_PADDLE, match_index, -1, 0, std::max(time_x, time_y));
+    }
+    if (match.ball_position.y >= Scalar(WALL_Y) || match.ball_position.y <= Scalar(-WALL_Y))
+    {
+        add_contact(contacts, count, max_contacts, CONTACT_WALL, match_index, 0, ball.y > 0.0f ? -1 : 1,
+                    closing_fraction(WALL_Y - std::fabs(previous_ball.y), WALL_Y - std::fabs(ball.y)));
+    }
+    if (match.ball_position.x >= Scalar(COURT_HALF_WIDTH) || match.ball_position.x <= Scalar(-COURT_HALF_WIDTH))
+    {
+        add_contact(contacts, count, max_contacts, CONTACT_GOAL, match_index, ball.x > 0.0f ? -1 : 1, 0,
+                    closing_fraction(COURT_HALF_WIDTH - std::fabs(previous_ball.x), COURT_HALF_WIDTH - std::fabs(ball.x)));
+    }
+
+    return count;
+}
+
+template <typename Scalar>
+int resolve_contacts(BasicMatch<Scalar> &match, const Contact *contacts, int contact_count)
+{
+    typedef typename BasicMatch<Scalar>::Vec3 Vec3;
+
+    int events = MATCH_EVENT_NONE;
+    const Scalar zero = 0.0f;
+
+    for (int i = 0; i < contact_count; i++)
+    {
+        const Contact &contact = contacts[i];
+        switch (contact.type)
+        {
+        case CONTACT_LEFT_PADDLE:
+        case CONTACT_RIGHT_PADDLE:
+        {
+            // Sent back the way the paddle faces, faster, and angled the way the paddle was moving
+            const Vec3 &paddle_movement = contact.type == CONTACT_LEFT_PADDLE ? match.paddle_movement : match.right_paddle_movement;
+            match.ball_movement.x = (float) contact.normal_x;
+            match.ball_speed *= Scalar(BALL_SPEED_GROWTH);
+            if (paddle_movement.y < zero)
+            {
+                match.ball_movement.y = -1.0f;
+            }
+            else if (paddle_movement.y > zero)
+            {
+                match.ball_movement.y = 1.0f;
+            }
+            events |= contact.type == CONTACT_LEFT_PADDLE ? MATCH_EVENT_LEFT_PADDLE_HIT : MATCH_EVENT_RIGHT_PADDLE_HIT;
+            break;
+        }
+
+        case CONTACT_WALL:
+            match.ball_movement.y = -match.ball_movement.y;
+            events |= MATCH_EVENT_WALL_BOUNCE;
+            break;
+
+        case CONTACT_GOAL:
+            // The goal faces back into the court, so it faces left when the ball went out on the right
+            if (contact.normal_x < 0) match.left_score++;
+            else                      match.right_score++;
+
+            // Play stops here, paddles included; nothing resets their movement until the next serve
+            match.ball_movement = Vec3(zero);
+            match.paddle_movement = Vec3(zero);
+            match.right_paddle_movement = Vec3(zero);
+            match.serve_direction = -match.serve_direction;
+            events |= MATCH_EVENT_BALL_OUT | MATCH_EVENT_POINT_SCORED;
+
+            if (match.left_score >= POINTS_TO_WIN || match.right_score >= POINTS_TO_WIN)
+            {
+                match.phase = PHASE_MATCH_OVER;
+                events |= MATCH_EVENT_MATCH_WON;
+            }
+            else
+            {
+                match.phase = PHASE_POINT_SCORED;
+                match.phase_timer = POINT_PAUSE_DURATION;
+            }
+            break;
+        }
+    }
+
+    return events;
+}
+
+template <typename Scalar>
+void reset_round(BasicMatch<Scalar> &match)
+{
+    BasicMatch<Scalar> next_round;
+    next_round.right_paddle_swtich = match.right_paddle_swtich;
+    next_round.ai_level = match.ai_level;
+    next_round.ai_random_state = match.ai_random_state;
+    next_round.left_score = match.left_score;
+    next_round.right_score = match.right_score;
+    next_round.serve_direction = match.serve_direction;
+
+    match = next_round;
+}
+
+template <typename Scalar>
+void reset_match(BasicMatch<Scalar> &match)
+{
+    BasicMatch<Scalar> next_match;
+    next_match.right_paddle_swtich = match.right_paddle_swtich;
+    next_match.ai_level = match.ai_level;
+    next_match.ai_random_state = match.ai_random_state;
+
+    match = next_match;
+}
+
+// Both number types are always compiled, whichever one SimScalar picks, so neither can rot
+template int update_match<float>(BasicMatch<float> &, const MatchInput &, float, ContactQueue *, int);
+template int update_match<Fixed>(BasicMatch<Fixed> &, const MatchInput &, float, ContactQueue *, int);
+template int detect_contacts<float>(const BasicMatch<float> &, float, int, Contact *, int);
+template int detect_contacts<Fixed>(const BasicMatch<Fixed> &, float, int, Contact *, int);
+template int resolve_contacts<float>(BasicMatch<float> &, const Contact *, int);
+template int resolve_contacts<Fixed>(BasicMatch<Fixed> &, const Contact *, int);
+template void reset_round<float>(BasicMatch<float> &);
+template void reset_round<Fixed>(BasicMatch<Fixed> &);
+template void reset_match<float>(BasicMatch<float> &);
+template void reset_match<Fixed>(BasicMatch<Fixed> &);
+
+uint64_t hash_match(const Match &match)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&match);
+
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(Match); i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+int predict_ball_path(const Match &match, glm::vec3 *points, int max_points)
+{
+    if (max_points <= 0) return 0;
+
+    glm::vec3 position = to_vec3(match.ball_position);
+    glm::vec3 velocity = to_vec3(match.ball_movement) * to_float(match.ball_speed);
+    int point_count = 0;
+    points[point_count++] = position;
+
+    if (velocity.x == 0.0f) return point_count;
+
+    float target_x = to_float(velocity.x > 0.0f ? match.right_paddle_position.x : match.paddle_position.x);
+
+    while (point_count < max_points)
+    {
+        float time_to_target = (target_x - position.x) / velocity.x;
+        float time_to_wall = velocity.y > 0.0f ? (WALL_Y - position.y) / velocity.y
+                           : velocity.y < 0.0f ? (-WALL_Y - position.y) / velocity.y
+                           : time_to_target;
+
+        if (time_to_target <= 0.0f) break;
+
+        if (time_to_wall > 0.0f && time_to_wall < time_to_target)
+        {
+            position += velocity * time_to_wall;
+            velocity.y = -velocity.y;
+            points[point_count++] = position;
+        }
+        else
+        {
+            position += velocity * time_to_target;
+            points[point_count++] = position;
+            break;
+        }
+    }
+
+    return point_count;
+}
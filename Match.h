@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include "glm/vec3.hpp"
+#include "FixedPoint.h"
+
+// The simulation's number type is picked at compile time. Define FIXED_POINT_SIMULATION to build it on
+// 16.16 integers, whose results replays and lockstep peers can rely on matching bit for bit.
+#ifdef FIXED_POINT_SIMULATION
+typedef Fixed SimScalar;
+#else
+typedef float SimScalar;
+#endif
+
+constexpr glm::vec3 INIT_PLAYER_1_SCALE = glm::vec3(0.8f, 1.2f, 0.0f);
+constexpr glm::vec3 INIT_PLAYER_2_SCALE = glm::vec3(1.0f, 1.0f, 0.0f);
+constexpr glm::vec3 INIT_BALL_SCALE = glm::vec3(0.25f, 0.25f, 0.0f);
+
+constexpr float COURT_HALF_WIDTH = 5.0f,
+WALL_Y = 3.5f,
+PADDLE_TRAVEL_TOP = 3.15f,
+PADDLE_TRAVEL_LENGTH = 6.3f,
+BALL_SPEED_GROWTH = 1.015f,
+INIT_BALL_SPEED = 3.0f,
+POINT_PAUSE_DURATION = 1.0f;
+
+constexpr int POINTS_TO_WIN = 5;
+
+// Serve waits for the serve input, a rally runs until the ball leaves the court, and a scored point
+// pauses briefly before the next serve. A finished match restarts on the next serve input.
+enum MatchPhase { PHASE_SERVE, PHASE_RALLY, PHASE_POINT_SCORED, PHASE_MATCH_OVER };
+
+// How well the right paddle AI plays; see PaddleAi.h
+enum AiLevel { AI_EASY, AI_NORMAL, AI_HARD, AI_LEVEL_COUNT };
+
+// Bit flags returned by update_match() describing what happened during the step
+enum MatchEvent
+{
+    MATCH_EVENT_NONE = 0,
+    MATCH_EVENT_LEFT_PADDLE_HIT = 1 << 0,
+    MATCH_EVENT_RIGHT_PADDLE_HIT = 1 << 1,
+    MATCH_EVENT_WALL_BOUNCE = 1 << 2,
+    MATCH_EVENT_BALL_OUT = 1 << 3,
+    MATCH_EVENT_POINT_SCORED = 1 << 4,
+    MATCH_EVENT_MATCH_WON = 1 << 5
+};
+
+// What the ball touched during a step. A step can touch a paddle, a wall and a goal at most, but both
+// paddles are reported if both somehow overlap it.
+enum ContactType : uint8_t { CONTACT_LEFT_PADDLE, CONTACT_RIGHT_PADDLE, CONTACT_WALL, CONTACT_GOAL };
+
+constexpr int MAX_CONTACTS_PER_STEP = 4;
+
+// One touch, small enough to queue thousands of a tick. The normal is the direction the surface faces,
+// back into the court; time_of_impact is how far through the step (0 to 1) the ball first reached it.
+struct Contact
+{
+    float    time_of_impact;
+    uint16_t match_index;
+    uint8_t  type;  // ContactType
+    int8_t   normal_x;
+    int8_t   normal_y;
+};
+
+class ContactQueue;
+
+struct MatchInput
+{
+    int paddle_direction = 0;        // -1 down, 0 still, 1 up
+    int right_paddle_direction = 0;  // ignored while the AI drives the right paddle
+    bool toggle_ai = false;
+    bool serve = false;
+};
+
+template <typename Scalar>
+struct BasicMatch
+{
+    typedef glm::vec<3, Scalar> Vec3;
+
+    Vec3 paddle_position = Vec3(-4.0f, 0.0f, 0.0f);
+    Vec3 paddle_movement = Vec3(0.0f, 0.0f, 0.0f);
+    Vec3 right_paddle_position = Vec3(4.0f, 0.0f, 0.0f);
+    Vec3 right_paddle_movement = Vec3(0.0f, 0.0f, 0.0f);
+    Vec3 ball_position = Vec3(0.0f, 0.0f, 0.0f);
+    Vec3 ball_movement = Vec3(0.0f, 0.0f, 0.0f);
+
+    Scalar paddle_speed = 3.0f;
+    Scalar ball_speed = INIT_BALL_SPEED;
+
+    int right_paddle_swtich = -1;
+
+    // Constraints
+    Scalar paddle_y_distance = 0.0f,
+    paddle_right_y_distance = 0.0f,
+    paddle_ball_x_distance = 0.0f,
+    paddle_ball_y_distance = 0.0f,
+    right_paddle_ball_x_distance = 0.0f,
+    right_paddle_ball_y_distance = 0.0f;
+
+    MatchPhase phase = PHASE_SERVE;
+    Scalar phase_timer = 0.0f;  // seconds left in the pause after a point
+    int left_score = 0,
+    right_score = 0;
+    Scalar serve_direction = -1.0f;  // alternates after every point
+
+    // Right paddle AI. Its plan, delay and random numbers live here too, so snapshots, rollback and
+    // replays reproduce it exactly.
+    AiLevel ai_level = AI_NORMAL;
+    Scalar ai_target_y = 0.0f;        // where the paddle is heading now
+    Scalar ai_planned_y = 0.0f;       // the latest prediction, waiting out the reaction delay
+    Scalar ai_reaction_timer = 0.0f;  // seconds until ai_planned_y becomes the target
+    uint32_t ai_random_state = 0x9E3779B9u;
+};
+
+typedef BasicMatch<SimScalar> Match;
+
+// Everything a match needs to continue lives in Match, so a snapshot is a plain copy
+static_assert(std::is_trivially_copyable<Match>::value, "Match must stay copyable with memcpy for snapshots");
+
+// Advances one match by delta_time seconds and returns a mask of MatchEvent flags. Instantiated for both
+// float and Fixed in Match.cpp. Given a queue, the step's contacts are appended to it too, stamped with
+// match_index, for effects and anything else that wants them in a batch.
+template <typename Scalar>
+int update_match(BasicMatch<Scalar> &match, const MatchInput &input, float delta_time,
+                 ContactQueue *contacts = nullptr, int match_index = 0);
+
+// Collision detection on its own: every contact the ball is making once a step has moved everything and
+// updated the distances, in the order resolve_contacts() applies them (paddles, wall, goal). Writes at
+// most max_contacts and returns how many; it only reads the match.
+template <typename Scalar>
+int detect_contacts(const BasicMatch<Scalar> &match, float delta_time, int match_index, Contact *contacts, int max_contacts);
+
+// The response to each contact in turn: bounces, speed-ups and scoring. Returns MatchEvent flags.
+template <typename Scalar>
+int resolve_contacts(BasicMatch<Scalar> &match, const Contact *contacts, int contact_count);
+
+// Puts the ball and paddles back for the next serve, keeping the score, serve order and AI settings
+template <typename Scalar>
+void reset_round(BasicMatch<Scalar> &match);
+
+// Clears the score as well; only the AI settings survive
+template <typename Scalar>
+void reset_match(BasicMatch<Scalar> &match);
+
+// Simulation vectors as floats, for rendering and anything else outside the simulation
+template <typename Scalar>
+inline glm::vec3 to_vec3(const glm::vec<3, Scalar> &vector)
+{
+    return glm::vec3(to_float(vector.x), to_float(vector.y), to_float(vector.z));
+}
+
+// FNV-1a over the raw bytes of the state. Two runs that hash differently at the same tick have diverged.
+uint64_t hash_match(const Match &match);
+
+// Traces the ball's straight-line path, reflecting off the walls, until it reaches the x of the paddle it
+// is heading for. Writes the start, every bounce and the end point; returns how many were written.
+int predict_ball_path(const Match &match, glm::vec3 *points, int max_points);
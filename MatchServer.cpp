@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include "MatchServer.h"
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // Enough matches per chunk to amortise the shared counter, few enough to balance across threads
+    constexpr int MATCHES_PER_CHUNK = 64;
+
+    // Falling further behind than this drops the missed ticks instead of running them back to back
+    constexpr int MAX_CATCH_UP_TICKS = 8;
+
+    constexpr int SOCKET_BUFFER_BYTES = 4 * 1024 * 1024;
+
+    int unpack_direction(uint8_t bits) { return bits == 1 ? 1 : bits == 2 ? -1 : 0; }
+
+    void write_u16(uint8_t *bytes, uint16_t value)
+    {
+        bytes[0] = (uint8_t) value;
+        bytes[1] = (uint8_t) (value >> 8);
+    }
+
+    void write_u32(uint8_t *bytes, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++) bytes[i] = (uint8_t) (value >> (8 * i));
+    }
+
+    uint16_t read_u16(const uint8_t *bytes) { return (uint16_t) (bytes[0] | bytes[1] << 8); }
+
+    int16_t quantise(SimScalar value) { return (int16_t) std::lround(to_float(value) * 256.0f); }
+
+    double percentile(std::vector<double> &values, double fraction)
+    {
+        size_t index = std::min((size_t) (fraction * values.size()), values.size() - 1);
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+}
+
+MatchServer::MatchServer() :
+    m_tick(0), m_tick_ms(8), m_packets_received(0), m_late_ticks(0)
+{
+}
+
+bool MatchServer::start(uint16_t port, int match_count, int thread_count, int tick_ms, AiLevel ai_level)
+{
+    if (!m_socket.open(port)) return false;
+    m_socket.set_buffer_size(SOCKET_BUFFER_BYTES);
+
+    match_count = std::max(1, std::min(match_count, MAX_MATCHES));
+    m_matches.assign(match_count, Match());
+    for (Match &match : m_matches) match.ai_level = ai_level;
+    m_slots.assign(match_count, ClientSlot());
+    m_pool.reset(new ThreadPool(thread_count));
+
+    m_tick = 0;
+    m_tick_ms = std::max(tick_ms, 1);
+    m_tick_times.clear();
+    m_tick_times.reserve(2 * 1000 / m_tick_ms);
+
+    std::cout << "Serving " << match_count << " matches on port " << port << " with "
+              << m_pool->get_thread_count() << " threads, " << m_tick_ms << " ms ticks" << std::endl;
+    return true;
+}
+
+void MatchServer::stop()
+{
+    m_socket.close();
+    m_pool.reset();
+}
+
+void MatchServer::receive_inputs()
+{
+    uint8_t packet[UdpSocket::MAX_PACKET_SIZE];
+    UdpAddress sender;
+    int size;
+    while ((size = m_socket.receive_from(packet, sizeof(packet), sender)) > 0)
+    {
+        m_packets_received++;
+        if (size < INPUT_PACKET_SIZE || packet[0] != PACKET_INPUT) continue;
+
+        int match_index = read_u16(packet + 1),
+            side = packet[3] != 0 ? 1 : 0;
+        if (match_index >= (int) m_slots.size()) continue;
+
+        // Whoever last sent input for a side owns it, so a client that changes address just carries on
+        ClientSlot &slot = m_slots[match_index];
+        slot.addresses[side] = sender;
+        slot.is_connected[side] = true;
+
+        // A serve press sticks until the tick that uses it, even if a later packet arrives without it
+        slot.inputs[side] = (packet[4] & 3) | (slot.inputs[side] & 4) | (packet[4] & 4);
+    }
+}
+
+void MatchServer::step_matches(int begin, int end)
+{
+    const float delta_time = m_tick_ms / 1000.0f;
+    uint8_t packet[STATE_PACKET_SIZE];
+
+    for (int i = begin; i < end; i++)
+    {
+        Match &match = m_matches[i];
+        ClientSlot &slot = m_slots[i];
+
+        // Matches nobody has joined yet are left alone; the AI covers a side that has no client
+        if (!slot.is_connected[0] && !slot.is_connected[1]) continue;
+
+        MatchInput input;
+        input.paddle_direction = unpack_direction(slot.inputs[0] & 3);
+        input.right_paddle_direction = unpack_direction(slot.inputs[1] & 3);
+        input.serve = ((slot.inputs[0] | slot.inputs[1]) & 4) != 0;
+        if ((match.right_paddle_swtich == -1) != slot.is_connected[1]) input.toggle_ai = true;
+
+        update_match(match, input, delta_time);
+        slot.inputs[0] &= 3;
+        slot.inputs[1] &= 3;
+
+        if ((i + m_tick) % STATE_INTERVAL_TICKS != 0) continue;
+
+        packet[0] = PACKET_STATE;
+        write_u32(packet + 1, m_tick);
+        write_u16(packet + 5, (uint16_t) i);
+        write_u16(packet + 7, (uint16_t) quantise(match.ball_position.x));
+        write_u16(packet + 9, (uint16_t) quantise(match.ball_position.y));
+        write_u16(packet + 11, (uint16_t) quantise(match.paddle_position.y));
+        write_u16(packet + 13, (uint16_t) quantise(match.right_paddle_position.y));
+        packet[15] = (uint8_t) match.left_score;
+        packet[16] = (uint8_t) match.right_score;
+        packet[17] = (uint8_t) match.phase;
+
+        // Sending from the workers is safe: each datagram is a single system call on a shared socket
+        for (int side = 0; side < 2; side++)
+        {
+            if (slot.is_connected[side]) m_socket.send_to(slot.addresses[side], packet, STATE_PACKET_SIZE);
+        }
+    }
+}
+
+void MatchServer::report(double elapsed_seconds)
+{
+    if (m_tick_times.empty()) return;
+
+    int tick_count = (int) m_tick_times.size();
+    double max_us = *std::max_element(m_tick_times.begin(), m_tick_times.end()),
+           p50_us = percentile(m_tick_times, 0.5),
+           p99_us = percentile(m_tick_times, 0.99),
+           p999_us = percentile(m_tick_times, 0.999);
+
+    std::cout << "tick " << m_tick << ": " << tick_count << " ticks, p50 " << p50_us << " us, p99 " << p99_us
+              << " us, p99.9 " << p999_us << " us, max " << max_us << " us, " << m_late_ticks << " late, "
+              << (int) (m_packets_received / elapsed_seconds) << " packets/s in" << std::endl;
+
+    m_tick_times.clear();
+    m_packets_received = 0;
+    m_late_ticks = 0;
+}
+
+void MatchServer::run(int seconds)
+{
+    const std::chrono::milliseconds tick_duration(m_tick_ms);
+    const std::function<void(int, int)> job = [this](int begin, int end) { step_matches(begin, end); };
+
+    Clock::time_point start = Clock::now(),
+                      next_tick = start,
+                      last_report = start;
+
+    while (m_socket.is_open() && (seconds <= 0 || Clock::now() - start < std::chrono::seconds(seconds)))
+    {
+        std::this_thread::sleep_until(next_tick);
+
+        Clock::time_point tick_start = Clock::now();
+        receive_inputs();
+        m_pool->parallel_for((int) m_matches.size(), MATCHES_PER_CHUNK, job);
+        m_tick++;
+
+        Clock::time_point tick_end = Clock::now();
+        m_tick_times.push_back(std::chrono::duration<double, std::micro>(tick_end - tick_start).count());
+
+        next_tick += tick_duration;
+        if (tick_end > next_tick)
+        {
+            m_late_ticks++;
+            if (tick_end - next_tick > tick_duration * MAX_CATCH_UP_TICKS) next_tick = tick_end;
+        }
+
+        if (tick_end - last_report >= std::chrono::seconds(1))
+        {
+            report(std::chrono::duration<double>(tick_end - last_report).count());
+            last_report = tick_end;
+        }
+    }
+}
+
+int run_client_swarm(const char *host, uint16_t port, int match_count, int seconds, int tick_ms)
+{
+    // Inputs are resent this often even when unchanged, so a lost packet is only a brief hiccup
+    constexpr int KEEPALIVE_TICKS = 8;
+
+    match_count = std::max(1, std::min(match_count, MatchServer::MAX_MATCHES));
+
+    UdpAddress server;
+    if (!UdpSocket::resolve(host, port, server)) return 1;
+
+    UdpSocket sockets[2];
+    for (UdpSocket &socket : sockets)
+    {
+        if (!socket.open(0)) return 1;
+        socket.set_buffer_size(SOCKET_BUFFER_BYTES);
+    }
+
+    std::vector<uint8_t> inputs(2 * match_count, 0);
+    std::vector<bool> has_heard(match_count, false);
+    uint32_t random_state = 0x2545F491u;
+
+    Clock::time_point start = Clock::now(),
+                      next_tick = start,
+                      last_report = start;
+    int states_received = 0;
+    uint32_t latest_server_tick = 0;
+
+    std::cout << "Swarm playing " << match_count << " matches against " << host << ":" << port << std::endl;
+
+    for (uint32_t tick = 0; Clock::now() - start < std::chrono::seconds(seconds); tick++)
+    {
+        uint8_t packet[UdpSocket::MAX_PACKET_SIZE];
+        for (int side = 0; side < 2; side++)
+        {
+            UdpAddress sender;
+            int size;
+            while ((size = sockets[side].receive_from(packet, sizeof(packet), sender)) > 0)
+            {
+                if (size < MatchServer::STATE_PACKET_SIZE || packet[0] != MatchServer::PACKET_STATE) continue;
+
+                int match_index = read_u16(packet + 5);
+                if (match_index < match_count) has_heard[match_index] = true;
+                latest_server_tick = std::max(latest_server_tick, (uint32_t) packet[1] | (uint32_t) packet[2] << 8 |
+                                                                  (uint32_t) packet[3] << 16 | (uint32_t) packet[4] << 24);
+                states_received++;
+            }
+        }
+
+        for (int i = 0; i < 2 * match_count; i++)
+        {
+            // Same bots as the rollback test: change direction every so often, serve now and then
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+
+            uint8_t input = inputs[i] & 3;
+            if (random_state % 16 == 0) input = (uint8_t) (random_state / 16 % 3);
+            if (random_state % 150 == 0) input |= 4;
+
+            if (input == inputs[i] && (i + tick) % KEEPALIVE_TICKS != 0) continue;
+            inputs[i] = input;
+
+            int side = i % 2;
+            packet[0] = MatchServer::PACKET_INPUT;
+            write_u16(packet + 1, (uint16_t) (i / 2));
+            packet[3] = (uint8_t) side;
+            packet[4] = input;
+            sockets[side].send_to(server, packet, MatchServer::INPUT_PACKET_SIZE);
+        }
+
+        Clock::time_point now = Clock::now();
+        if (now - last_report >= std::chrono::seconds(1))
+        {
+            double elapsed_seconds = std::chrono::duration<double>(now - last_report).count();
+            std::cout << "swarm: " << (int) (states_received / elapsed_seconds) << " states/s, server tick "
+                      << latest_server_tick << std::endl;
+            states_received = 0;
+            last_report = now;
+        }
+
+        next_tick += std::chrono::milliseconds(tick_ms);
+        if (now - next_tick > std::chrono::milliseconds(tick_ms * MAX_CATCH_UP_TICKS)) next_tick = now;
+        std::this_thread::sleep_until(next_tick);
+    }
+
+    int heard_count = (int) std::count(has_heard.begin(), has_heard.end(), true);
+    std::cout << "Swarm heard from " << heard_count << " of " << match_count << " matches" << std::endl;
+    return heard_count == match_count ? 0 : 1;
+}
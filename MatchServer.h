@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Match.h"
+#include "ThreadPool.h"
+#include "UdpSocket.h"
+
+// Headless authoritative server for many independent matches. Clients send their paddle input for a match
+// and side over UDP, and the AI plays any right paddle without a client. The server steps every match at
+// a fixed rate on a thread pool and sends each match's state back to both of its clients every few ticks.
+// Tick times are reported as percentiles once a second.
+class MatchServer
+{
+public:
+    // Client to server: u8 type, u16 match, u8 side, u8 input (bits 0-1 direction, bit 2 serve)
+    static constexpr uint8_t PACKET_INPUT = 'I';
+    static constexpr int     INPUT_PACKET_SIZE = 5;
+
+    // Server to client: u8 type, u32 tick, u16 match, i16 ball x and y, i16 left and right paddle y
+    // (positions in 1/256 units), u8 left score, u8 right score, u8 phase
+    static constexpr uint8_t PACKET_STATE = 'S';
+    static constexpr int     STATE_PACKET_SIZE = 18;
+
+    // States go out at a fraction of the tick rate, staggered by match so every tick sends about as many
+    static constexpr int STATE_INTERVAL_TICKS = 6;
+
+    static constexpr int MAX_MATCHES = 65535;
+
+private:
+    struct ClientSlot
+    {
+        UdpAddress addresses[2];
+        bool       is_connected[2] = { false, false };
+        uint8_t    inputs[2] = { 0, 0 };  // latest input per side; serve only counts for one tick
+    };
+
+    void receive_inputs();
+    void step_matches(int begin, int end);
+    void report(double elapsed_seconds);
+
+    UdpSocket                   m_socket;
+    std::unique_ptr<ThreadPool> m_pool;
+
+    std::vector<Match>      m_matches;
+    std::vector<ClientSlot> m_slots;
+
+    uint32_t m_tick;
+    int      m_tick_ms;
+
+    // Microseconds per tick since the last report, plus counters for the same period
+    std::vector<double> m_tick_times;
+    int m_packets_received;
+    int m_late_ticks;
+
+public:
+    MatchServer();
+
+    // thread_count counts the server thread too; 0 uses every hardware thread
+    bool start(uint16_t port, int match_count, int thread_count, int tick_ms, AiLevel ai_level = AI_NORMAL);
+    void stop();
+
+    // Runs the tick loop for the given number of seconds, or forever when it is 0
+    void run(int seconds);
+
+    int      const get_match_count() const { return (int) m_matches.size(); };
+    uint32_t const get_tick()        const { return m_tick;                  };
+};
+
+// Plays both sides of match_count matches against a server with scripted bots, from two sockets (one per
+// side), for the given number of seconds. Prints how many states arrived per second and returns 0 if
+// every match heard from the server.
+int run_client_swarm(const char *host, uint16_t port, int match_count, int seconds, int tick_ms);
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Marks the end of the free list and the dense entries past the live ones
+constexpr uint32_t POOL_NO_SLOT = UINT32_MAX;
+
+// Names one object in an ObjectPool. The generation tells apart successive objects that lived in the
+// same slot, so a handle kept past its object's destruction simply stops resolving instead of reaching
+// whatever was spawned there next. A default handle never resolves.
+struct PoolHandle
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const PoolHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const PoolHandle &other) const { return !(*this == other); }
+};
+
+// Fixed-capacity storage for objects that come and go many times a second. Everything is allocated up
+// front, so spawning and destroying never touch the heap. Live objects are kept packed at the front of
+// one array for fast iteration: destroying one moves the last live object into its place. Handles go
+// through a slot table, so they stay valid however the objects move. Pointers do not; they hold only
+// until the next destroy.
+template <typename T>
+class ObjectPool
+{
+private:
+    struct Slot
+    {
+        uint32_t dense_index;  // where the object is while the slot is in use
+        uint32_t generation;   // bumped on every destroy
+        uint32_t next_free;
+    };
+
+    std::vector<T>        m_objects;      // [0, m_count) are live
+    std::vector<uint32_t> m_dense_slots;  // the slot of each live object
+    std::vector<Slot>     m_slots;
+    uint32_t m_free_head;
+    int      m_count;
+
+public:
+    explicit ObjectPool(int capacity = 0) { reset(capacity); }
+
+    // Sizes the pool and destroys everything in it. Outstanding handles stop resolving.
+    void reset(int capacity)
+    {
+        capacity = capacity > 0 ? capacity : 0;
+        m_objects.assign(capacity, T());
+        m_dense_slots.assign(capacity, POOL_NO_SLOT);
+
+        // Generations start at 1 so the default handle, generation 0, never matches, and carry on
+        // counting through a reset so handles from before it do not match either
+        size_t old_capacity = m_slots.size();
+        m_slots.resize(capacity);
+        for (int i = 0; i < capacity; i++)
+        {
+            uint32_t generation = (size_t) i < old_capacity ? m_slots[i].generation + 1 : 1;
+            m_slots[i] = { 0, generation, i + 1 < capacity ? (uint32_t) i + 1 : POOL_NO_SLOT };
+        }
+        m_free_head = capacity > 0 ? 0 : POOL_NO_SLOT;
+        m_count = 0;
+    }
+
+    // Returns a default handle, which never resolves, when the pool is full
+    PoolHandle spawn(const T &object = T())
+    {
+        if (m_free_head == POOL_NO_SLOT) return PoolHandle();
+
+        uint32_t slot_index = m_free_head;
+        Slot &slot = m_slots[slot_index];
+        m_free_head = slot.next_free;
+
+        slot.dense_index = (uint32_t) m_count;
+        m_objects[m_count] = object;
+        m_dense_slots[m_count] = slot_index;
+        m_count++;
+
+        return { slot_index, slot.generation };
+    }
+
+    // Returns false if the handle no longer resolves; the pool is left untouched then
+    bool destroy(PoolHandle handle)
+    {
+        if (!is_alive(handle)) return false;
+        destroy_at((int) m_slots[handle.index].dense_index);
+        return true;
+    }
+
+    // By position among the live objects. The last one moves into its place, so a loop that destroys
+    // as it goes should run from the back.
+    void destroy_at(int dense_index)
+    {
+        uint32_t slot_index = m_dense_slots[dense_index];
+        int last = m_count - 1;
+
+        m_objects[dense_index] = m_objects[last];
+        m_dense_slots[dense_index] = m_dense_slots[last];
+        m_slots[m_dense_slots[dense_index]].dense_index = (uint32_t) dense_index;
+        m_dense_slots[last] = POOL_NO_SLOT;
+        m_count = last;
+
+        Slot &slot = m_slots[slot_index];
+        slot.generation++;
+        slot.next_free = m_free_head;
+        m_free_head = slot_index;
+    }
+
+    void clear()
+    {
+        while (m_count > 0) destroy_at(m_count - 1);
+    }
+
+    bool is_alive(PoolHandle handle) const
+    {
+        // A slot's generation moves on whenever its object is destroyed, so only the current object's
+        // handles match
+        return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation;
+    }
+
+    // Null when the handle no longer resolves
+    T *get(PoolHandle handle)             { return is_alive(handle) ? &m_objects[m_slots[handle.index].dense_index] : nullptr; }
+    const T *get(PoolHandle handle) const { return is_alive(handle) ? &m_objects[m_slots[handle.index].dense_index] : nullptr; }
+
+    PoolHandle get_handle(int dense_index) const
+    {
+        uint32_t slot_index = m_dense_slots[dense_index];
+        return { slot_index, m_slots[slot_index].generation };
+    }
+
+    // The live objects, packed
+    T       &operator[](int dense_index)       { return m_objects[dense_index]; }
+    const T &operator[](int dense_index) const { return m_objects[dense_index]; }
+    T       *begin()       { return m_objects.data();           }
+    T       *end()         { return m_objects.data() + m_count; }
+    const T *begin() const { return m_objects.data();           }
+    const T *end()   const { return m_objects.data() + m_count; }
+
+    int const get_count()    const { return m_count;                 };
+    int const get_capacity() const { return (int) m_objects.size(); };
+};
@@ -0,0 +1,95 @@
+#include "PaddleAi.h"
+
+namespace
+{
+    struct AiProfile
+    {
+        float reaction_time;  // seconds
+        float max_error;      // world units either side of the true intercept
+    };
+
+    // Easy misses about one shot in three; hard almost never does
+    constexpr AiProfile AI_PROFILES[AI_LEVEL_COUNT] = {
+        { 0.40f, 0.90f },  // AI_EASY
+        { 0.15f, 0.45f },  // AI_NORMAL
+        { 0.05f, 0.10f }   // AI_HARD
+    };
+
+    // Uniform in [-1, 1), built from 16 random bits so it converts to either number type exactly
+    template <typename Scalar>
+    Scalar next_error_fraction(uint32_t &random_state)
+    {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        return Scalar((float) (random_state >> 16) / 32768.0f) - Scalar(1.0f);
+    }
+}
+
+template <typename Scalar>
+void plan_ai_intercept(BasicMatch<Scalar> &match)
+{
+    const AiProfile &profile = AI_PROFILES[match.ai_level >= 0 && match.ai_level < AI_LEVEL_COUNT ? match.ai_level : AI_NORMAL];
+    const Scalar zero = 0.0f,
+                 wall = WALL_Y;
+
+    Scalar planned_y = zero;
+    Scalar travel_x = match.right_paddle_position.x - Scalar((INIT_BALL_SCALE.x + INIT_PLAYER_2_SCALE.x) / 2) - match.ball_position.x;
+
+    if (match.ball_movement.x > zero && travel_x > zero)
+    {
+        // Speed cancels out: the height changes by travel_x times the path's slope
+        Scalar y = match.ball_position.y + travel_x * match.ball_movement.y / match.ball_movement.x;
+
+        // Unfold the bounces. The slope is at most 1 and the court is wider than it is tall, so this
+        // runs at most a couple of times.
+        while (y > wall || y < -wall) y = (y > wall ? wall + wall : -wall - wall) - y;
+
+        planned_y = y + next_error_fraction<Scalar>(match.ai_random_state) * Scalar(profile.max_error);
+    }
+
+    const Scalar travel_top = PADDLE_TRAVEL_TOP,
+                 travel_bottom = PADDLE_TRAVEL_TOP - PADDLE_TRAVEL_LENGTH;
+    if (planned_y > travel_top) planned_y = travel_top;
+    if (planned_y < travel_bottom) planned_y = travel_bottom;
+
+    match.ai_planned_y = planned_y;
+    match.ai_reaction_timer = profile.reaction_time;
+}
+
+template <typename Scalar>
+void steer_ai_paddle(BasicMatch<Scalar> &match, Scalar step)
+{
+    typedef typename BasicMatch<Scalar>::Vec3 Vec3;
+    const Scalar zero = 0.0f;
+
+    if (match.ai_reaction_timer > zero)
+    {
+        match.ai_reaction_timer -= step;
+        if (match.ai_reaction_timer <= zero) match.ai_target_y = match.ai_planned_y;
+    }
+
+    Scalar offset = match.ai_target_y - match.right_paddle_position.y,
+           max_move = match.paddle_speed * step;
+
+    match.right_paddle_movement = Vec3(zero);
+    if (offset > max_move)
+    {
+        match.right_paddle_movement.y = 1.0f;
+        match.right_paddle_position.y += max_move;
+    }
+    else if (offset < -max_move)
+    {
+        match.right_paddle_movement.y = -1.0f;
+        match.right_paddle_position.y -= max_move;
+    }
+    else
+    {
+        match.right_paddle_position.y = match.ai_target_y;
+    }
+}
+
+template void plan_ai_intercept<float>(BasicMatch<float> &);
+template void plan_ai_intercept<Fixed>(BasicMatch<Fixed> &);
+template void steer_ai_paddle<float>(BasicMatch<float> &, float);
+template void steer_ai_paddle<Fixed>(BasicMatch<Fixed> &, Fixed);
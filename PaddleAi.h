@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Match.h"
+
+// Computer player for the right paddle. Instead of chasing the ball's current height every tick, it
+// works out where the ball will cross the paddle's x, folding the path back at each wall, and heads
+// there. That prediction only changes when the ball's path does (a serve or a paddle hit), so it is made
+// then and nowhere else, which keeps the per-tick cost to a few comparisons.
+//
+// Difficulty comes from a reaction delay before a new prediction is acted on and a random error added to
+// it. Both are drawn from the match's own state, so the AI is as deterministic as the rest of the game.
+// Both functions are instantiated for float and Fixed in PaddleAi.cpp.
+
+// Predicts the intercept for the ball's current path and starts the reaction delay. A ball heading away
+// sends the paddle back to the middle.
+template <typename Scalar>
+void plan_ai_intercept(BasicMatch<Scalar> &match);
+
+// Moves the right paddle toward its target for one step, stopping exactly on it rather than overshooting
+template <typename Scalar>
+void steer_ai_paddle(BasicMatch<Scalar> &match, Scalar step);
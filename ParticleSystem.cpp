@@ -0,0 +1,190 @@
+#define GL_SILENCE_DEPRECATION
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "ParticleSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PARTICLES_USE_SSE 1
+    #include <emmintrin.h>
+#endif
+
+#ifndef GL_VERTEX_PROGRAM_POINT_SIZE
+    #define GL_VERTEX_PROGRAM_POINT_SIZE 0x8642
+#endif
+
+namespace
+{
+    constexpr float TWO_PI = 6.28318530718f;
+
+    // Life given to the padding lanes past the last particle so they never read as dead
+    constexpr float PADDING_LIFE = 1.0e30f;
+
+    int padded(int count) { return (count + 3) & ~3; }
+}
+
+ParticleSystem::ParticleSystem(int capacity, float drag) :
+    m_capacity(capacity), m_count(0),
+    m_position_x(padded(capacity)), m_position_y(padded(capacity)),
+    m_velocity_x(padded(capacity)), m_velocity_y(padded(capacity)),
+    m_life(padded(capacity)), m_inverse_lifetime(padded(capacity)),
+    m_fade(padded(capacity)), m_colour(padded(capacity)),
+    m_drag(drag), m_random_state(0x9E3779B9u),
+    m_program(nullptr), m_position_x_attribute(-1), m_position_y_attribute(-1),
+    m_colour_attribute(-1), m_fade_attribute(-1), m_point_size_uniform(-1)
+{
+    std::fill(m_life.begin(), m_life.end(), PADDING_LIFE);
+}
+
+float ParticleSystem::random_float()
+{
+    // xorshift32; quality is irrelevant here, speed is not
+    m_random_state ^= m_random_state << 13;
+    m_random_state ^= m_random_state >> 17;
+    m_random_state ^= m_random_state << 5;
+    return (m_random_state >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleSystem::emit(const glm::vec3 &position, const glm::vec3 &velocity, float spread, int count,
+                          const glm::vec4 &colour, float lifetime)
+{
+    uint8_t channels[4] = {
+        (uint8_t) (colour.r * 255.0f), (uint8_t) (colour.g * 255.0f),
+        (uint8_t) (colour.b * 255.0f), (uint8_t) (colour.a * 255.0f)
+    };
+    uint32_t packed_colour;
+    std::memcpy(&packed_colour, channels, sizeof(packed_colour));
+
+    float speed = std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+    float heading = speed > 0.0f ? std::atan2(velocity.y, velocity.x) : 0.0f;
+    if (speed == 0.0f) spread = TWO_PI;
+
+    // When the pool is full new particles are dropped rather than evicting live ones
+    int last = std::min(m_count + count, m_capacity);
+    for (int i = m_count; i < last; i++)
+    {
+        float angle = heading + (random_float() - 0.5f) * spread;
+        float particle_speed = (speed > 0.0f ? speed : 1.0f) * (0.5f + 0.5f * random_float());
+        float particle_lifetime = lifetime * (0.75f + 0.5f * random_float());
+
+        m_position_x[i] = position.x;
+        m_position_y[i] = position.y;
+        m_velocity_x[i] = std::cos(angle) * particle_speed;
+        m_velocity_y[i] = std::sin(angle) * particle_speed;
+        m_life[i] = particle_lifetime;
+        m_inverse_lifetime[i] = 1.0f / particle_lifetime;
+        m_fade[i] = 1.0f;
+        m_colour[i] = packed_colour;
+    }
+    m_count = last;
+}
+
+void ParticleSystem::update(float delta_time)
+{
+    float drag_factor = std::exp(-m_drag * delta_time);
+    int padded_count = padded(m_count);
+    bool is_any_dead = false;
+
+#ifdef PARTICLES_USE_SSE
+    const __m128 dt = _mm_set1_ps(delta_time),
+                 drag = _mm_set1_ps(drag_factor),
+                 zero = _mm_setzero_ps();
+    __m128 dead = zero;
+
+    for (int i = 0; i < padded_count; i += 4)
+    {
+        __m128 velocity_x = _mm_mul_ps(_mm_loadu_ps(&m_velocity_x[i]), drag),
+               velocity_y = _mm_mul_ps(_mm_loadu_ps(&m_velocity_y[i]), drag),
+               life = _mm_sub_ps(_mm_loadu_ps(&m_life[i]), dt);
+
+        _mm_storeu_ps(&m_velocity_x[i], velocity_x);
+        _mm_storeu_ps(&m_velocity_y[i], velocity_y);
+        _mm_storeu_ps(&m_position_x[i], _mm_add_ps(_mm_loadu_ps(&m_position_x[i]), _mm_mul_ps(velocity_x, dt)));
+        _mm_storeu_ps(&m_position_y[i], _mm_add_ps(_mm_loadu_ps(&m_position_y[i]), _mm_mul_ps(velocity_y, dt)));
+        _mm_storeu_ps(&m_life[i], life);
+        _mm_storeu_ps(&m_fade[i], _mm_max_ps(_mm_mul_ps(life, _mm_loadu_ps(&m_inverse_lifetime[i])), zero));
+
+        dead = _mm_or_ps(dead, _mm_cmple_ps(life, zero));
+    }
+
+    is_any_dead = _mm_movemask_ps(dead) != 0;
+#else
+    for (int i = 0; i < m_count; i++)
+    {
+        m_velocity_x[i] *= drag_factor;
+        m_velocity_y[i] *= drag_factor;
+        m_position_x[i] += m_velocity_x[i] * delta_time;
+        m_position_y[i] += m_velocity_y[i] * delta_time;
+        m_life[i] -= delta_time;
+        m_fade[i] = std::fmax(m_life[i] * m_inverse_lifetime[i], 0.0f);
+
+        is_any_dead = is_any_dead || m_life[i] <= 0.0f;
+    }
+#endif
+
+    if (is_any_dead) kill_dead_particles();
+
+    for (int i = m_count; i < padded(m_count); i++) m_life[i] = PADDING_LIFE;
+}
+
+void ParticleSystem::kill_dead_particles()
+{
+    int i = 0;
+    while (i < m_count)
+    {
+        if (m_life[i] > 0.0f)
+        {
+            i++;
+            continue;
+        }
+
+        int last = --m_count;
+        m_position_x[i] = m_position_x[last];
+        m_position_y[i] = m_position_y[last];
+        m_velocity_x[i] = m_velocity_x[last];
+        m_velocity_y[i] = m_velocity_y[last];
+        m_life[i] = m_life[last];
+        m_inverse_lifetime[i] = m_inverse_lifetime[last];
+        m_fade[i] = m_fade[last];
+        m_colour[i] = m_colour[last];
+    }
+}
+
+void ParticleSystem::set_program(ShaderProgram &program)
+{
+    GLuint program_id = program.get_program_id();
+    m_program = &program;
+    m_position_x_attribute = glGetAttribLocation(program_id, "positionX");
+    m_position_y_attribute = glGetAttribLocation(program_id, "positionY");
+    m_colour_attribute     = glGetAttribLocation(program_id, "colour");
+    m_fade_attribute       = glGetAttribLocation(program_id, "fade");
+    m_point_size_uniform   = glGetUniformLocation(program_id, "pointSize");
+}
+
+void ParticleSystem::render(float point_size) const
+{
+    if (m_count == 0 || m_program == nullptr) return;
+
+    glUseProgram(m_program->get_program_id());
+    glUniform1f(m_point_size_uniform, point_size);
+    m_program->set_model_matrix(glm::mat4(1.0f));
+
+    // The SoA arrays are streamed to GL directly: no per-frame vertex building at all
+    glVertexAttribPointer(m_position_x_attribute, 1, GL_FLOAT, false, 0, m_position_x.data());
+    glVertexAttribPointer(m_position_y_attribute, 1, GL_FLOAT, false, 0, m_position_y.data());
+    glVertexAttribPointer(m_colour_attribute, 4, GL_UNSIGNED_BYTE, true, 0, m_colour.data());
+    glVertexAttribPointer(m_fade_attribute, 1, GL_FLOAT, false, 0, m_fade.data());
+    glEnableVertexAttribArray(m_position_x_attribute);
+    glEnableVertexAttribArray(m_position_y_attribute);
+    glEnableVertexAttribArray(m_colour_attribute);
+    glEnableVertexAttribArray(m_fade_attribute);
+
+    glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+    glDrawArrays(GL_POINTS, 0, m_count);
+
+    glDisableVertexAttribArray(m_position_x_attribute);
+    glDisableVertexAttribArray(m_position_y_attribute);
+    glDisableVertexAttribArray(m_colour_attribute);
+    glDisableVertexAttribArray(m_fade_attribute);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <cstdint>
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "ShaderProgram.h"
+
+// Fixed-capacity particle pool stored as structure-of-arrays. Dead particles are removed by moving the
+// last live particle into their slot, so the live range is always [0, count) and can be handed to GL as-is.
+class ParticleSystem
+{
+private:
+    float random_float();
+    void  kill_dead_particles();
+
+    int m_capacity;
+    int m_count;
+
+    // Each array is padded to a multiple of four so the SIMD loop never needs a scalar tail
+    std::vector<float> m_position_x;
+    std::vector<float> m_position_y;
+    std::vector<float> m_velocity_x;
+    std::vector<float> m_velocity_y;
+    std::vector<float> m_life;
+    std::vector<float> m_inverse_lifetime;
+    std::vector<float> m_fade;
+    std::vector<uint32_t> m_colour;
+
+    float    m_drag;
+    uint32_t m_random_state;
+
+    // Looked up once in set_program() rather than on every draw
+    ShaderProgram *m_program;
+    GLint m_position_x_attribute;
+    GLint m_position_y_attribute;
+    GLint m_colour_attribute;
+    GLint m_fade_attribute;
+    GLint m_point_size_uniform;
+
+public:
+    ParticleSystem(int capacity, float drag);
+
+    void emit(const glm::vec3 &position, const glm::vec3 &velocity, float spread, int count,
+              const glm::vec4 &colour, float lifetime);
+    void update(float delta_time);
+    void clear() { m_count = 0; };
+
+    // xorshift must never be seeded with zero
+    void seed(uint32_t seed) { m_random_state = seed != 0 ? seed : 0x9E3779B9u; };
+
+    // The program render() draws with; call it again if the program is reloaded
+    void set_program(ShaderProgram &program);
+
+    // One GL_POINTS draw straight from the particle arrays; point_size is in pixels
+    void render(float point_size) const;
+
+    int const get_count()    const { return m_count;    };
+    int const get_capacity() const { return m_capacity; };
+};
@@ -0,0 +1,245 @@
+#define GL_SILENCE_DEPRECATION
+
+#include <algorithm>
+#include "PostProcessor.h"
+
+namespace
+{
+    constexpr char V_POST_SHADER_PATH[] = "shaders/vertex_post.glsl",
+                   F_BLUR_SHADER_PATH[] = "shaders/fragment_blur.glsl",
+                   F_COMPOSITE_SHADER_PATH[] = "shaders/fragment_composite.glsl";
+
+    constexpr float BLOOM_STRENGTH = 1.5f,
+                    VIGNETTE_STRENGTH = 0.6f,
+                    SCANLINE_STRENGTH = 0.25f;
+
+    const char *STAGE_NAMES[] = { "scene", "glow", "blur", "composite" };
+}
+
+PostProcessor::PostProcessor() :
+    m_window_width(0), m_window_height(0),
+    m_output_x(0), m_output_y(0), m_output_width(0), m_output_height(0),
+    m_scene_target(), m_glow_target(), m_blur_targets(),
+    m_texel_step_uniform(-1), m_effect_strength_uniform(-1),
+    m_effects(0), m_is_available(false), m_is_pixel_mode(false),
+    m_is_profiling(false), m_stage_start(0), m_stage_ticks(), m_profiled_frames(0)
+{
+}
+
+bool PostProcessor::create_target(RenderTarget &target, int width, int height, GLint filter)
+{
+    target.width  = width;
+    target.height = height;
+
+    glGenTextures(1, &target.texture_id);
+    glBindTexture(GL_TEXTURE_2D, target.texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &target.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture_id, 0);
+
+    bool is_complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    return is_complete;
+}
+
+void PostProcessor::destroy_target(RenderTarget &target)
+{
+    if (target.framebuffer != 0) glDeleteFramebuffers(1, &target.framebuffer);
+    if (target.texture_id != 0)  glDeleteTextures(1, &target.texture_id);
+    target = RenderTarget();
+}
+
+bool PostProcessor::initialise(int window_width, int window_height, int scene_width, int scene_height)
+{
+    m_window_width  = window_width;
+    m_window_height = window_height;
+    m_is_pixel_mode = scene_width < window_width || scene_height < window_height;
+
+    // Whole-number scaling keeps every scene pixel the same size on screen
+    int output_scale = m_is_pixel_mode ? std::max(1, std::min(window_width / scene_width, window_height / scene_height)) : 1;
+    m_output_width  = m_is_pixel_mode ? scene_width * output_scale : window_width;
+    m_output_height = m_is_pixel_mode ? scene_height * output_scale : window_height;
+    m_output_x = (window_width - m_output_width) / 2;
+    m_output_y = (window_height - m_output_height) / 2;
+
+    m_blur_program.load(V_POST_SHADER_PATH, F_BLUR_SHADER_PATH);
+    m_composite_program.load(V_POST_SHADER_PATH, F_COMPOSITE_SHADER_PATH);
+
+    m_texel_step_uniform      = glGetUniformLocation(m_blur_program.get_program_id(), "texelStep");
+    m_effect_strength_uniform = glGetUniformLocation(m_composite_program.get_program_id(), "effectStrength");
+
+    glUseProgram(m_composite_program.get_program_id());
+    glUniform1i(glGetUniformLocation(m_composite_program.get_program_id(), "bloom"), 1);
+
+    int glow_width  = (int) (scene_width * GLOW_SCALE),
+        glow_height = (int) (scene_height * GLOW_SCALE);
+
+    // Nearest keeps pixel-mode texels crisp; elsewhere linear filtering does the up- and down-sampling
+    // between resolutions for free
+    m_is_available = create_target(m_scene_target, scene_width, scene_height, m_is_pixel_mode ? GL_NEAREST : GL_LINEAR) &&
+                     create_target(m_glow_target, glow_width, glow_height, GL_LINEAR) &&
+                     create_target(m_blur_targets[0], glow_width / 2, glow_height / 2, GL_LINEAR) &&
+                     create_target(m_blur_targets[1], glow_width / 2, glow_height / 2, GL_LINEAR);
+
+    if (!m_is_available)
+    {
+        std::cout << "Post-processing unavailable: framebuffer objects are incomplete" << std::endl;
+        shutdown();
+    }
+
+    return m_is_available;
+}
+
+void PostProcessor::shutdown()
+{
+    destroy_target(m_scene_target);
+    destroy_target(m_glow_target);
+    destroy_target(m_blur_targets[0]);
+    destroy_target(m_blur_targets[1]);
+    m_is_available = false;
+}
+
+void PostProcessor::toggle_profiling()
+{
+    m_is_profiling = !m_is_profiling;
+    m_profiled_frames = 0;
+    for (Uint64 &ticks : m_stage_ticks) ticks = 0;
+}
+
+void PostProcessor::bind_target(const RenderTarget *target)
+{
+    if (target == nullptr)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(m_output_x, m_output_y, m_output_width, m_output_height);
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+    glViewport(0, 0, target->width, target->height);
+}
+
+void PostProcessor::mark_stage_end(Stage stage)
+{
+    if (!m_is_profiling) return;
+
+    glFinish();
+    Uint64 now = SDL_GetPerformanceCounter();
+    m_stage_ticks[stage] += now - m_stage_start;
+    m_stage_start = now;
+}
+
+void PostProcessor::draw_fullscreen_quad(ShaderProgram &program)
+{
+    float vertices[] = {
+        -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f,  // triangle 1
+        -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f   // triangle 2
+    };
+
+    glVertexAttribPointer(program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
+    glEnableVertexAttribArray(program.get_position_attribute());
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glDisableVertexAttribArray(program.get_position_attribute());
+}
+
+void PostProcessor::begin_scene()
+{
+    if (m_is_profiling)
+    {
+        glFinish();
+        m_stage_start = SDL_GetPerformanceCounter();
+    }
+
+    bind_target(is_active() ? &m_scene_target : nullptr);
+}
+
+void PostProcessor::begin_glow()
+{
+    mark_stage_end(STAGE_SCENE);
+
+    bind_target(&m_glow_target);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void PostProcessor::finish()
+{
+    if (!is_active())
+    {
+        mark_stage_end(STAGE_SCENE);
+    }
+    else
+    {
+        bool is_bloom_on = is_enabled(POST_BLOOM);
+
+        // Blending would mix the passes with whatever the targets held last frame
+        glDisable(GL_BLEND);
+
+        if (is_bloom_on)
+        {
+            mark_stage_end(STAGE_GLOW);
+
+            // Horizontal blur doubles as the half-to-quarter downsample; vertical stays at quarter
+            glUseProgram(m_blur_program.get_program_id());
+
+            bind_target(&m_blur_targets[0]);
+            glBindTexture(GL_TEXTURE_2D, m_glow_target.texture_id);
+            glUniform2f(m_texel_step_uniform, 1.0f / m_glow_target.width, 0.0f);
+            draw_fullscreen_quad(m_blur_program);
+
+            bind_target(&m_blur_targets[1]);
+            glBindTexture(GL_TEXTURE_2D, m_blur_targets[0].texture_id);
+            glUniform2f(m_texel_step_uniform, 0.0f, 1.0f / m_blur_targets[0].height);
+            draw_fullscreen_quad(m_blur_program);
+
+            mark_stage_end(STAGE_BLUR);
+        }
+        else
+        {
+            mark_stage_end(STAGE_SCENE);
+        }
+
+        bind_target(nullptr);
+        if (m_output_width != m_window_width || m_output_height != m_window_height)
+        {
+            // Clear the letterbox bars; glClear ignores the viewport so this covers the whole window
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        glUseProgram(m_composite_program.get_program_id());
+        glUniform3f(m_effect_strength_uniform,
+            is_bloom_on ? BLOOM_STRENGTH : 0.0f,
+            is_enabled(POST_VIGNETTE) ? VIGNETTE_STRENGTH : 0.0f,
+            is_enabled(POST_SCANLINES) ? SCANLINE_STRENGTH : 0.0f);
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, m_blur_targets[1].texture_id);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_scene_target.texture_id);
+        draw_fullscreen_quad(m_composite_program);
+
+        glEnable(GL_BLEND);
+        mark_stage_end(STAGE_COMPOSITE);
+    }
+
+    if (m_is_profiling && ++m_profiled_frames == PROFILE_REPORT_FRAMES)
+    {
+        double milliseconds_per_tick = 1000.0 / SDL_GetPerformanceFrequency() / PROFILE_REPORT_FRAMES;
+
+        std::cout << "post-processing ms/frame:";
+        for (int stage = 0; stage < STAGE_COUNT; stage++)
+        {
+            std::cout << ' ' << STAGE_NAMES[stage] << '=' << m_stage_ticks[stage] * milliseconds_per_tick;
+            m_stage_ticks[stage] = 0;
+        }
+        std::cout << std::endl;
+        m_profiled_frames = 0;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "ShaderProgram.h"
+
+enum PostEffect { POST_BLOOM = 1 << 0, POST_VIGNETTE = 1 << 1, POST_SCANLINES = 1 << 2 };
+
+// Optional full-screen effects. The scene goes into one full-resolution target; bloom is fed by a
+// separate half-resolution glow target that only the glowing objects are drawn into, blurred through
+// two quarter-resolution targets. Everything is then resolved in a single fused composite pass.
+// With every effect off the scene is drawn straight to the window and this class costs nothing.
+//
+// In pixel mode the scene target is a small fixed resolution (e.g. 320x240) sampled with nearest
+// filtering and shown at the largest whole-number scale that fits the window, letterboxed.
+class PostProcessor
+{
+private:
+    struct RenderTarget
+    {
+        GLuint framebuffer;
+        GLuint texture_id;
+        int    width;
+        int    height;
+    };
+
+    enum Stage { STAGE_SCENE, STAGE_GLOW, STAGE_BLUR, STAGE_COMPOSITE, STAGE_COUNT };
+
+    bool create_target(RenderTarget &target, int width, int height, GLint filter);
+    void destroy_target(RenderTarget &target);
+    void bind_target(const RenderTarget *target);
+    void draw_fullscreen_quad(ShaderProgram &program);
+    void mark_stage_end(Stage stage);
+
+    int m_window_width;
+    int m_window_height;
+
+    // Where the scene lands on the window; the whole window unless pixel mode letterboxes it
+    int m_output_x;
+    int m_output_y;
+    int m_output_width;
+    int m_output_height;
+
+    RenderTarget m_scene_target;
+    RenderTarget m_glow_target;
+    RenderTarget m_blur_targets[2];
+
+    ShaderProgram m_blur_program;
+    ShaderProgram m_composite_program;
+
+    // Looked up once in initialise() rather than every frame
+    GLint m_texel_step_uniform;
+    GLint m_effect_strength_uniform;
+
+    int  m_effects;
+    bool m_is_available;
+    bool m_is_pixel_mode;
+
+    // Per-stage CPU+GPU cost, only measured while profiling because it forces a glFinish per stage
+    bool   m_is_profiling;
+    Uint64 m_stage_start;
+    Uint64 m_stage_ticks[STAGE_COUNT];
+    int    m_profiled_frames;
+
+public:
+    static constexpr float GLOW_SCALE = 0.5f;
+    static constexpr int   PROFILE_REPORT_FRAMES = 120;
+
+    PostProcessor();
+
+    // A scene size smaller than the window turns on pixel mode
+    bool initialise(int window_width, int window_height, int scene_width, int scene_height);
+    void shutdown();
+
+    void toggle_effect(PostEffect effect) { m_effects ^= effect; };
+    void toggle_profiling();
+
+    bool const is_active()            const { return m_is_available && (m_effects != 0 || m_is_pixel_mode); };
+    bool const is_enabled(int effect) const { return m_is_available && (m_effects & effect) != 0;         };
+    bool const is_pixel_mode()        const { return m_is_available && m_is_pixel_mode;                   };
+
+    // Scene pixels per window pixel, for mapping window-space viewports onto the scene target
+    float const get_scene_scale() const { return is_pixel_mode() ? (float) m_scene_target.width / m_window_width : 1.0f; };
+
+    // Frame sequence: begin_scene(), draw the scene, begin_glow() and draw glowing objects if bloom is
+    // on, then finish() to resolve everything onto the window
+    void begin_scene();
+    void begin_glow();
+    void finish();
+};
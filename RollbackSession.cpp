@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include "RollbackSession.h"
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // Packet layout: u8 type, u32 acknowledged tick, u32 first tick, u8 count, then one byte per tick
+    constexpr int PACKET_HEADER_SIZE = 10;
+
+    // Bits 0-1 paddle direction (0 still, 1 up, 2 down), bit 2 serve
+    int unpack_direction(uint8_t bits) { return bits == 1 ? 1 : bits == 2 ? -1 : 0; }
+
+    void write_u32(uint8_t *bytes, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++) bytes[i] = (uint8_t) (value >> (8 * i));
+    }
+
+    uint32_t read_u32(const uint8_t *bytes)
+    {
+        return (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+    }
+
+    double microseconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+}
+
+RollbackSession::RollbackSession() :
+    m_local_side(0), m_input_delay(DEFAULT_INPUT_DELAY), m_rollback_window(DEFAULT_ROLLBACK_WINDOW),
+    m_tick(0), m_local_input_end(0), m_remote_confirmed(0), m_peer_acknowledged(0),
+    m_earliest_mismatch(NO_MISMATCH), m_frame_resimulation_us(0.0)
+{
+    std::fill(m_local_inputs, m_local_inputs + HISTORY, 0);
+    std::fill(m_remote_inputs, m_remote_inputs + HISTORY, 0);
+    std::fill(m_remote_input_ticks, m_remote_input_ticks + HISTORY, UINT32_MAX);
+    std::fill(m_used_remote_inputs, m_used_remote_inputs + HISTORY, 0);
+}
+
+bool RollbackSession::start(int local_side, uint16_t local_port, const char *peer_host, uint16_t peer_port,
+                            int input_delay, int rollback_window)
+{
+    m_local_side = local_side != 0 ? 1 : 0;
+    m_input_delay = std::min(std::max(input_delay, 0), 16);
+    m_rollback_window = std::min(std::max(rollback_window, 1), (int) HISTORY / 2 - m_input_delay);
+
+    if (!m_socket.open(local_port) || !m_socket.set_peer(peer_host, peer_port))
+    {
+        stop();
+        return false;
+    }
+
+    m_snapshots.initialise(m_rollback_window + 2, 1);
+
+    // Both peers treat the first input_delay ticks as idle on both paddles, so nobody waits for them
+    std::fill(m_remote_input_ticks, m_remote_input_ticks + HISTORY, UINT32_MAX);
+    for (int tick = 0; tick < m_input_delay; tick++)
+    {
+        m_local_inputs[tick] = 0;
+        m_remote_inputs[tick] = 0;
+        m_remote_input_ticks[tick] = tick;
+    }
+
+    m_tick = 0;
+    m_local_input_end = m_input_delay;
+    m_remote_confirmed = m_input_delay;
+    m_peer_acknowledged = m_input_delay;
+    m_earliest_mismatch = NO_MISMATCH;
+    m_stats = Stats();
+    return true;
+}
+
+void RollbackSession::stop()
+{
+    m_socket.close();
+}
+
+uint8_t RollbackSession::pack_input(const MatchInput &input)
+{
+    // The local player may use either set of paddle keys
+    int direction = input.paddle_direction != 0 ? input.paddle_direction : input.right_paddle_direction;
+    return (uint8_t) ((direction > 0 ? 1 : direction < 0 ? 2 : 0) | (input.serve ? 4 : 0));
+}
+
+MatchInput RollbackSession::combine_inputs(uint8_t local_input, uint8_t remote_input) const
+{
+    uint8_t left = m_local_side == 0 ? local_input : remote_input,
+            right = m_local_side == 0 ? remote_input : local_input;
+
+    MatchInput input;
+    input.paddle_direction = unpack_direction(left & 3);
+    input.right_paddle_direction = unpack_direction(right & 3);
+    input.serve = ((left | right) & 4) != 0;
+    return input;
+}
+
+uint8_t RollbackSession::remote_input_for(uint32_t tick) const
+{
+    if (m_remote_input_ticks[tick & HISTORY_MASK] == tick) return m_remote_inputs[tick & HISTORY_MASK];
+
+    // Prediction: the remote player keeps doing whatever they last confirmed, minus any serve press
+    if (m_remote_confirmed == 0) return 0;
+    return m_remote_inputs[(m_remote_confirmed - 1) & HISTORY_MASK] & 3;
+}
+
+int RollbackSession::simulate(Match &match, uint32_t tick, float delta_time, ContactQueue *contacts)
+{
+    m_snapshots.save(tick, &match);
+
+    uint8_t remote_input = remote_input_for(tick);
+    m_used_remote_inputs[tick & HISTORY_MASK] = remote_input;
+
+    return update_match(match, combine_inputs(m_local_inputs[tick & HISTORY_MASK], remote_input), delta_time, contacts);
+}
+
+void RollbackSession::roll_back(Match &match, float delta_time)
+{
+    if (m_earliest_mismatch == NO_MISMATCH) return;
+
+    uint32_t from_tick = m_earliest_mismatch;
+    m_earliest_mismatch = NO_MISMATCH;
+
+    Clock::time_point start = Clock::now();
+    if (!m_snapshots.restore(from_tick, &match))
+    {
+        std::cout << "Rollback to tick " << from_tick << " is outside the snapshot history; peers have desynchronised" << std::endl;
+        return;
+    }
+    for (uint32_t tick = from_tick; tick < m_tick; tick++) simulate(match, tick, delta_time);
+
+    m_stats.rollbacks++;
+    m_stats.resimulated_ticks += m_tick - from_tick;
+    m_frame_resimulation_us += microseconds_since(start);
+}
+
+void RollbackSession::receive_packets()
+{
+    uint8_t packet[UdpSocket::MAX_PACKET_SIZE];
+    int size;
+    while ((size = m_socket.receive(packet, sizeof(packet))) > 0)
+    {
+        if (size < PACKET_HEADER_SIZE || packet[0] != PACKET_INPUTS) continue;
+
+        uint32_t acknowledged = read_u32(packet + 1),
+                 first_tick = read_u32(packet + 5);
+        int count = packet[9];
+        if (size < PACKET_HEADER_SIZE + count) continue;
+
+        m_peer_acknowledged = std::max(m_peer_acknowledged, std::min(acknowledged, m_local_input_end));
+
+        for (int i = 0; i < count; i++)
+        {
+            uint32_t tick = first_tick + i;
+            int slot = tick & HISTORY_MASK;
+
+            // Already known, or so far ahead it would overwrite history still in use
+            if (tick < m_remote_confirmed || tick >= m_tick + HISTORY / 2) continue;
+            if (m_remote_input_ticks[slot] == tick) continue;
+
+            uint8_t remote_input = packet[PACKET_HEADER_SIZE + i];
+            m_remote_inputs[slot] = remote_input;
+            m_remote_input_ticks[slot] = tick;
+
+            if (tick < m_tick && remote_input != m_used_remote_inputs[slot])
+            {
+                m_earliest_mismatch = std::min(m_earliest_mismatch, tick);
+            }
+        }
+
+        while (m_remote_input_ticks[m_remote_confirmed & HISTORY_MASK] == m_remote_confirmed) m_remote_confirmed++;
+    }
+}
+
+void RollbackSession::send_inputs()
+{
+    // Every packet repeats all inputs the peer has not acknowledged, so a lost packet costs nothing extra
+    uint32_t first_tick = std::max(m_peer_acknowledged, m_local_input_end - std::min(m_local_input_end, (uint32_t) MAX_INPUTS_PER_PACKET));
+    int count = m_local_input_end - first_tick;
+
+    uint8_t packet[PACKET_HEADER_SIZE + MAX_INPUTS_PER_PACKET];
+    packet[0] = PACKET_INPUTS;
+    write_u32(packet + 1, m_remote_confirmed);
+    write_u32(packet + 5, first_tick);
+    packet[9] = (uint8_t) count;
+    for (int i = 0; i < count; i++) packet[PACKET_HEADER_SIZE + i] = m_local_inputs[(first_tick + i) & HISTORY_MASK];
+
+    m_socket.send(packet, PACKET_HEADER_SIZE + count);
+    m_socket.flush();
+}
+
+void RollbackSession::end_frame()
+{
+    m_stats.frames++;
+    m_stats.resimulation_us += m_frame_resimulation_us;
+    m_stats.max_frame_resimulation_us = std::max(m_stats.max_frame_resimulation_us, m_frame_resimulation_us);
+    m_frame_resimulation_us = 0.0;
+}
+
+int RollbackSession::advance(Match &match, const MatchInput &local_input, float delta_time, ContactQueue *contacts)
+{
+    int events = MATCH_EVENT_NONE;
+
+    receive_packets();
+    roll_back(match, delta_time);
+
+    if (m_tick >= m_remote_confirmed + m_rollback_window)
+    {
+        m_stats.stalled_ticks++;
+    }
+    else
+    {
+        // The local input takes effect input_delay ticks from now, giving it time to reach the peer
+        m_local_inputs[m_local_input_end & HISTORY_MASK] = pack_input(local_input);
+        m_local_input_end++;
+
+        events = simulate(match, m_tick, delta_time, contacts);
+        m_tick++;
+    }
+
+    send_inputs();
+    end_frame();
+    return events;
+}
+
+void RollbackSession::poll(Match &match, float delta_time)
+{
+    receive_packets();
+    roll_back(match, delta_time);
+    send_inputs();
+    end_frame();
+}
+
+RollbackSession::Stats RollbackSession::take_stats()
+{
+    Stats stats = m_stats;
+    m_stats = Stats();
+    return stats;
+}
+
+int run_rollback_loopback_test(int tick_count, int tick_ms, int latency_ms, int jitter_ms, float loss, uint16_t base_port,
+                               int input_delay, int rollback_window)
+{
+    RollbackSession sessions[2];
+    Match matches[2];
+    MatchInput inputs[2];
+    uint32_t random_states[2] = { 0x1234567u, 0x89ABCDEu };
+
+    for (int side = 0; side < 2; side++)
+    {
+        if (!sessions[side].start(side, base_port + side, "127.0.0.1", base_port + 1 - side, input_delay, rollback_window)) return 1;
+        sessions[side].set_conditions(latency_ms, jitter_ms, loss);
+    }
+
+    const float delta_time = tick_ms / 1000.0f;
+    Clock::time_point next_frame = Clock::now();
+
+    while (sessions[0].get_tick() < (uint32_t) tick_count || sessions[1].get_tick() < (uint32_t) tick_count)
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            if (sessions[side].get_tick() >= (uint32_t) tick_count)
+            {
+                sessions[side].poll(matches[side], delta_time);
+                continue;
+            }
+
+            // A bot that changes direction every so often and serves now and then
+            uint32_t &random_state = random_states[side];
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            if (random_state % 16 == 0) inputs[side].paddle_direction = (int) (random_state / 16 % 3) - 1;
+            inputs[side].serve = random_state % 150 == 0;
+
+            sessions[side].advance(matches[side], inputs[side], delta_time);
+        }
+
+        next_frame += std::chrono::milliseconds(tick_ms);
+        std::this_thread::sleep_until(next_frame);
+    }
+
+    // Let the last inputs and acknowledgements cross the link
+    Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+    while (!(sessions[0].is_synchronised() && sessions[1].is_synchronised()) && Clock::now() < deadline)
+    {
+        for (int side = 0; side < 2; side++) sessions[side].poll(matches[side], delta_time);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    for (int side = 0; side < 2; side++)
+    {
+        RollbackSession::Stats stats = sessions[side].take_stats();
+        int frames = std::max(stats.frames, 1);
+        std::cout << (side == 0 ? "Left " : "Right") << ": " << stats.rollbacks << " rollbacks, "
+                  << (float) stats.resimulated_ticks / frames << " resimulated ticks/frame, "
+                  << stats.resimulation_us / frames << " us/frame average, "
+                  << stats.max_frame_resimulation_us << " us worst frame, "
+                  << stats.stalled_ticks << " stalled frames" << std::endl;
+    }
+
+    bool is_matching = sessions[0].is_synchronised() && sessions[1].is_synchronised() &&
+                       hash_match(matches[0]) == hash_match(matches[1]);
+    std::cout << (is_matching ? "Peers agree" : "Peers DIVERGED") << " after " << tick_count << " ticks (score "
+              << matches[0].left_score << " - " << matches[0].right_score << ")" << std::endl;
+    return is_matching ? 0 : 1;
+}
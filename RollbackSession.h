@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include "Match.h"
+#include "SnapshotRing.h"
+#include "UdpSocket.h"
+
+// Two-player networked match using input delay plus rollback. Each peer owns one paddle and sends its
+// inputs for every tick over UDP, resending whatever the other side has not acknowledged. A tick whose
+// remote input has not arrived yet is simulated with the last confirmed one; when the real input turns
+// out different, the match is restored from the snapshot before that tick and resimulated. The local
+// peer never runs more than `rollback_window` ticks ahead of the last confirmed remote input and stalls
+// instead. Both peers must use the same input delay and the same build.
+class RollbackSession
+{
+public:
+    struct Stats
+    {
+        int    frames = 0;
+        int    rollbacks = 0;
+        int    resimulated_ticks = 0;
+        int    stalled_ticks = 0;
+        double resimulation_us = 0.0;
+        double max_frame_resimulation_us = 0.0;
+    };
+
+private:
+    static constexpr uint8_t PACKET_INPUTS = 'R';
+    static constexpr int     MAX_INPUTS_PER_PACKET = 255;
+
+    // Must stay a power of two and comfortably larger than any rollback window
+    static constexpr uint32_t HISTORY = 256,
+                              HISTORY_MASK = HISTORY - 1;
+
+    static uint8_t pack_input(const MatchInput &input);
+    MatchInput combine_inputs(uint8_t local_input, uint8_t remote_input) const;
+
+    void receive_packets();
+    void send_inputs();
+    void end_frame();
+    uint8_t remote_input_for(uint32_t tick) const;
+    int simulate(Match &match, uint32_t tick, float delta_time, ContactQueue *contacts = nullptr);
+    void roll_back(Match &match, float delta_time);
+
+    UdpSocket    m_socket;
+    SnapshotRing m_snapshots;
+
+    int m_local_side;  // 0 plays the left paddle, 1 the right
+    int m_input_delay;
+    int m_rollback_window;
+
+    uint32_t m_tick;                 // next tick to simulate
+    uint32_t m_local_input_end;      // local inputs are known for ticks before this
+    uint32_t m_remote_confirmed;     // every remote input before this tick has arrived
+    uint32_t m_peer_acknowledged;    // the peer has every local input before this tick
+    uint32_t m_earliest_mismatch;    // oldest tick simulated with a wrong prediction, or NO_MISMATCH
+
+    uint8_t  m_local_inputs[HISTORY];
+    uint8_t  m_remote_inputs[HISTORY];
+    uint32_t m_remote_input_ticks[HISTORY];  // which tick each remote slot holds
+    uint8_t  m_used_remote_inputs[HISTORY];  // what each simulated tick assumed for the remote side
+
+    Stats  m_stats;
+    double m_frame_resimulation_us;
+
+public:
+    static constexpr uint32_t NO_MISMATCH = UINT32_MAX;
+
+    static constexpr int DEFAULT_INPUT_DELAY = 2,
+                         DEFAULT_ROLLBACK_WINDOW = 30;
+
+    RollbackSession();
+
+    bool start(int local_side, uint16_t local_port, const char *peer_host, uint16_t peer_port,
+               int input_delay = DEFAULT_INPUT_DELAY, int rollback_window = DEFAULT_ROLLBACK_WINDOW);
+    void stop();
+
+    void set_conditions(int latency_ms, int jitter_ms, float loss) { m_socket.set_conditions(latency_ms, jitter_ms, loss); };
+
+    // Exchanges inputs, corrects any misprediction, then simulates one new tick with the local input
+    // (only its own paddle direction and serve are used). Returns that tick's MatchEvent flags, or
+    // MATCH_EVENT_NONE when it had to stall for the peer. Only that new tick's contacts go into contacts;
+    // resimulated ticks already had theirs.
+    int advance(Match &match, const MatchInput &local_input, float delta_time, ContactQueue *contacts = nullptr);
+
+    // Exchanges inputs and corrects mispredictions without simulating anything new
+    void poll(Match &match, float delta_time);
+
+    // Resimulation cost since the last call; each advance() or poll() counts as one frame
+    Stats take_stats();
+
+    bool     const is_active()       const { return m_socket.is_open(); };
+    bool     const is_synchronised() const { return m_remote_confirmed >= m_tick && m_peer_acknowledged >= m_local_input_end; };
+    uint32_t const get_tick()        const { return m_tick; };
+};
+
+// Runs two sessions against each other over real UDP sockets on 127.0.0.1 with scripted random input and
+// the given link conditions, then checks that both ended in the same state. Prints the resimulation
+// cost per frame and returns 0 on success.
+int run_rollback_loopback_test(int tick_count, int tick_ms, int latency_ms, int jitter_ms, float loss, uint16_t base_port,
+                               int input_delay = RollbackSession::DEFAULT_INPUT_DELAY,
+                               int rollback_window = RollbackSession::DEFAULT_ROLLBACK_WINDOW);
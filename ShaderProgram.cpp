@@ -30,6 +30,7 @@ void ShaderProgram::load(const char *vertex_shader_file, const char *fragment_sh
     
     m_position_attribute  = glGetAttribLocation(m_program_id, "position");
     m_tex_coord_attribute = glGetAttribLocation(m_program_id, "texCoord");
+    m_vertex_colour_attribute = glGetAttribLocation(m_program_id, "colour");
     
     set_colour(1.0f, 1.0f, 1.0f, 1.0f);
     
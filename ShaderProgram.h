@@ -28,6 +28,7 @@ private:
 
     GLuint m_position_attribute;
     GLuint m_tex_coord_attribute;
+    GLuint m_vertex_colour_attribute;  // only in shaders with per-vertex colour
 
     GLuint m_vertex_shader;
     GLuint m_fragment_shader;
@@ -44,6 +45,7 @@ public:
     GLuint const get_program_id()               const { return m_program_id;          };
     GLuint const get_position_attribute()       const { return m_position_attribute;  };
     GLuint const get_tex_coordinate_attribute() const { return m_tex_coord_attribute; };
+    GLuint const get_vertex_colour_attribute()  const { return m_vertex_colour_attribute; };
     
     void set_program_id(GLuint program_id)                         { m_program_id = program_id;                   };
 };
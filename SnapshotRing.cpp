@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <cstring>
+#include "SnapshotRing.h"
+
+SnapshotRing::SnapshotRing() : m_capacity(1), m_match_count(0), m_ticks(1, EMPTY_SLOT)
+{
+}
+
+void SnapshotRing::initialise(int capacity, int match_count)
+{
+    m_capacity = std::max(capacity, 1);
+    m_match_count = match_count;
+    m_states.assign(m_capacity * match_count, Match());
+    m_ticks.assign(m_capacity, EMPTY_SLOT);
+}
+
+void SnapshotRing::save(uint32_t tick, const Match *matches)
+{
+    int slot = tick % m_capacity;
+    std::memcpy(&m_states[slot * m_match_count], matches, sizeof(Match) * m_match_count);
+    m_ticks[slot] = tick;
+}
+
+bool SnapshotRing::restore(uint32_t tick, Match *matches) const
+{
+    if (!has(tick)) return false;
+
+    int slot = tick % m_capacity;
+    std::memcpy(matches, &m_states[slot * m_match_count], sizeof(Match) * m_match_count);
+    return true;
+}
+
+uint64_t SnapshotRing::hash(uint32_t tick) const
+{
+    if (!has(tick)) return 0;
+
+    int slot = tick % m_capacity;
+    uint64_t combined = 0;
+    for (int i = 0; i < m_match_count; i++)
+    {
+        // Mixed with the index so two matches trading states still change the result
+        combined ^= hash_match(m_states[slot * m_match_count + i]) * (2 * i + 1);
+    }
+    return combined;
+}
+
+void SnapshotRing::clear()
+{
+    std::fill(m_ticks.begin(), m_ticks.end(), EMPTY_SLOT);
+}
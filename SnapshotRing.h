@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Match.h"
+
+// Preallocated history of the last `capacity` ticks of every match, indexed by tick number. Saving
+// overwrites the oldest tick; nothing is allocated after construction.
+class SnapshotRing
+{
+private:
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    int m_capacity;
+    int m_match_count;
+
+    std::vector<Match>    m_states;  // m_match_count consecutive states per slot
+    std::vector<uint32_t> m_ticks;   // which tick each slot currently holds
+
+public:
+    SnapshotRing();
+
+    // Sizes the ring and forgets anything saved so far
+    void initialise(int capacity, int match_count);
+
+    void save(uint32_t tick, const Match *matches);
+
+    // Copies the saved states back; returns false if that tick was never saved or has been overwritten
+    bool restore(uint32_t tick, Match *matches) const;
+
+    // Combined hash of every match at that tick, or 0 if it is not held
+    uint64_t hash(uint32_t tick) const;
+
+    void clear();
+
+    bool const has(uint32_t tick) const { return m_ticks[tick % m_capacity] == tick; };
+    int  const get_capacity()     const { return m_capacity; };
+};
@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "SpectatorStream.h"
+
+using namespace spectator_packet;
+
+namespace
+{
+    constexpr int PACKET_HEADER_SIZE = 11,
+                  ACK_SIZE = 6,
+                  FIELD_COUNT = 7;
+
+    // Largest possible delta for one tick: the flag byte plus a 3 byte varint per 16-bit field
+    constexpr int MAX_TICK_SIZE = 1 + FIELD_COUNT * 3;
+
+    // Distinct baselines encoded per batch; any further subscribers get the baseline-free packet
+    constexpr int MAX_ENCODINGS = 8;
+
+    void write_u32(uint8_t *bytes, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++) bytes[i] = (uint8_t) (value >> (8 * i));
+    }
+
+    uint32_t read_u32(const uint8_t *bytes)
+    {
+        return (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+    }
+
+    int16_t quantise(SimScalar value) { return (int16_t) std::lround(to_float(value) * 256.0f); }
+
+    void get_fields(const SpectatorFrame &frame, int *fields)
+    {
+        fields[0] = frame.ball_x;
+        fields[1] = frame.ball_y;
+        fields[2] = frame.left_paddle_y;
+        fields[3] = frame.right_paddle_y;
+        fields[4] = frame.left_score;
+        fields[5] = frame.right_score;
+        fields[6] = frame.phase;
+    }
+
+    void set_fields(SpectatorFrame &frame, const int *fields)
+    {
+        frame.ball_x = (int16_t) fields[0];
+        frame.ball_y = (int16_t) fields[1];
+        frame.left_paddle_y = (int16_t) fields[2];
+        frame.right_paddle_y = (int16_t) fields[3];
+        frame.left_score = (uint8_t) fields[4];
+        frame.right_score = (uint8_t) fields[5];
+        frame.phase = (uint8_t) fields[6];
+    }
+
+    // Zigzag maps small negative and positive deltas alike to small unsigned numbers
+    int write_delta(uint8_t *bytes, int delta)
+    {
+        uint32_t value = ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31);
+        int size = 0;
+        while (value >= 0x80)
+        {
+            bytes[size++] = (uint8_t) (value | 0x80);
+            value >>= 7;
+        }
+        bytes[size++] = (uint8_t) value;
+        return size;
+    }
+
+    // Returns the bytes read, or 0 if the varint runs off the end
+    int read_delta(const uint8_t *bytes, int available, int &delta)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < available && i < 5; i++)
+        {
+            value |= (uint32_t) (bytes[i] & 0x7F) << (7 * i);
+            if ((bytes[i] & 0x80) == 0)
+            {
+                delta = (int) (value >> 1) ^ -(int) (value & 1);
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    int encode_tick(uint8_t *bytes, const SpectatorFrame &previous, const SpectatorFrame &frame)
+    {
+        int previous_fields[FIELD_COUNT], fields[FIELD_COUNT];
+        get_fields(previous, previous_fields);
+        get_fields(frame, fields);
+
+        uint8_t changed = 0;
+        int size = 1;
+        for (int i = 0; i < FIELD_COUNT; i++)
+        {
+            if (fields[i] == previous_fields[i]) continue;
+            changed |= 1 << i;
+            size += write_delta(bytes + size, fields[i] - previous_fields[i]);
+        }
+        bytes[0] = changed;
+        return size;
+    }
+}
+
+bool SpectatorFrame::operator==(const SpectatorFrame &other) const
+{
+    return ball_x == other.ball_x && ball_y == other.ball_y &&
+           left_paddle_y == other.left_paddle_y && right_paddle_y == other.right_paddle_y &&
+           left_score == other.left_score && right_score == other.right_score && phase == other.phase;
+}
+
+SpectatorFrame make_spectator_frame(const Match &match)
+{
+    SpectatorFrame frame;
+    frame.ball_x = quantise(match.ball_position.x);
+    frame.ball_y = quantise(match.ball_position.y);
+    frame.left_paddle_y = quantise(match.paddle_position.y);
+    frame.right_paddle_y = quantise(match.right_paddle_position.y);
+    frame.left_score = (uint8_t) match.left_score;
+    frame.right_score = (uint8_t) match.right_score;
+    frame.phase = (uint8_t) match.phase;
+    return frame;
+}
+
+void apply_spectator_frame(const SpectatorFrame &frame, Match &match)
+{
+    match.ball_position.x = frame.ball_x / 256.0f;
+    match.ball_position.y = frame.ball_y / 256.0f;
+    match.paddle_position.y = frame.left_paddle_y / 256.0f;
+    match.right_paddle_position.y = frame.right_paddle_y / 256.0f;
+    match.left_score = frame.left_score;
+    match.right_score = frame.right_score;
+    match.phase = (MatchPhase) frame.phase;
+}
+
+SpectatorBroadcaster::SpectatorBroadcaster() :
+    m_tick_end(0), m_sent_end(0), m_timeline(0), m_encodings(MAX_ENCODINGS), m_encoding_count(0)
+{
+    std::fill(m_frame_ticks, m_frame_ticks + HISTORY, NO_BASELINE);
+}
+
+bool SpectatorBroadcaster::open(uint16_t port)
+{
+    if (!m_socket.open(port)) return false;
+
+    std::cout << "Broadcasting to spectators on port " << port << std::endl;
+    return true;
+}
+
+void SpectatorBroadcaster::close()
+{
+    m_socket.close();
+    m_subscribers.clear();
+}
+
+void SpectatorBroadcaster::record(uint32_t tick, const Match &match)
+{
+    // A jump (a rewind, say) leaves older frames unusable as baselines, here and on every spectator
+    if (tick != m_tick_end)
+    {
+        std::fill(m_frame_ticks, m_frame_ticks + HISTORY, NO_BASELINE);
+        for (Subscriber &subscriber : m_subscribers) subscriber.acknowledged_tick = NO_BASELINE;
+        m_sent_end = tick;
+        m_timeline++;
+    }
+
+    m_frames[tick & HISTORY_MASK] = make_spectator_frame(match);
+    m_frame_ticks[tick & HISTORY_MASK] = tick;
+    m_tick_end = tick + 1;
+}
+
+void SpectatorBroadcaster::receive_messages()
+{
+    uint8_t packet[UdpSocket::MAX_PACKET_SIZE];
+    UdpAddress sender;
+    int size;
+    while ((size = m_socket.receive_from(packet, sizeof(packet), sender)) > 0)
+    {
+        if (packet[0] != JOIN && (packet[0] != ACK || size < ACK_SIZE)) continue;
+
+        auto found = std::find_if(m_subscribers.begin(), m_subscribers.end(),
+                                  [&](const Subscriber &subscriber) { return subscriber.address == sender; });
+        if (found == m_subscribers.end())
+        {
+            // An acknowledgement from a stranger is a spectator we forgot about, say after a restart
+            if ((int) m_subscribers.size() >= MAX_SUBSCRIBERS) continue;
+            m_subscribers.push_back({ sender, NO_BASELINE, Clock::now() });
+            found = m_subscribers.end() - 1;
+        }
+
+        found->last_heard = Clock::now();
+        if (packet[0] != ACK) continue;
+
+        // Only a tick from this timeline that is still in the history can be a baseline; anything else is
+        // a spectator that has not caught up with a jump yet
+        uint32_t tick = read_u32(packet + 2);
+        if (tick == NO_BASELINE)
+        {
+            found->acknowledged_tick = NO_BASELINE;
+        }
+        else if (packet[1] == m_timeline && tick < m_tick_end && has_frame(tick) &&
+                 (found->acknowledged_tick == NO_BASELINE || tick > found->acknowledged_tick))
+        {
+            found->acknowledged_tick = tick;
+        }
+    }
+
+    Clock::time_point timeout = Clock::now() - std::chrono::milliseconds(SUBSCRIBER_TIMEOUT_MS);
+    m_subscribers.erase(std::remove_if(m_subscribers.begin(), m_subscribers.end(),
+                                       [&](const Subscriber &subscriber) { return subscriber.last_heard < timeout; }),
+                        m_subscribers.end());
+}
+
+const SpectatorBroadcaster::Encoding &SpectatorBroadcaster::encode(uint32_t baseline_tick, uint32_t first_tick)
+{
+    for (int i = 0; i < m_encoding_count; i++)
+    {
+        if (m_encodings[i].baseline_tick == baseline_tick) return m_encodings[i];
+    }
+
+    // Out of room: fall back to the baseline-free packet, which everyone can decode
+    if (m_encoding_count >= MAX_ENCODINGS - 1 && baseline_tick != NO_BASELINE) return encode(NO_BASELINE, first_tick);
+
+    Encoding &encoding = m_encodings[m_encoding_count++];
+    encoding.baseline_tick = baseline_tick;
+
+    uint8_t *bytes = encoding.bytes;
+    bytes[0] = STATE;
+    bytes[1] = m_timeline;
+    write_u32(bytes + 2, baseline_tick);
+    write_u32(bytes + 6, first_tick);
+
+    // A default frame is all zeros, PHASE_SERVE included
+    SpectatorFrame previous = baseline_tick == NO_BASELINE ? SpectatorFrame() : m_frames[baseline_tick & HISTORY_MASK];
+
+    int size = PACKET_HEADER_SIZE,
+        count = 0;
+    for (uint32_t tick = first_tick; tick < m_tick_end && size + MAX_TICK_SIZE <= UdpSocket::MAX_PACKET_SIZE; tick++)
+    {
+        const SpectatorFrame &frame = m_frames[tick & HISTORY_MASK];
+        size += encode_tick(bytes + size, previous, frame);
+        previous = frame;
+        count++;
+    }
+    bytes[10] = (uint8_t) count;
+    encoding.size = size;
+
+    m_stats.encodings++;
+    return encoding;
+}
+
+void SpectatorBroadcaster::send_batch()
+{
+    uint32_t first_tick = std::max(m_sent_end, m_tick_end - std::min(m_tick_end, (uint32_t) MAX_BATCH_TICKS));
+    m_sent_end = m_tick_end;
+    m_encoding_count = 0;
+    m_stats.batches++;
+
+    for (const Subscriber &subscriber : m_subscribers)
+    {
+        uint32_t baseline_tick = subscriber.acknowledged_tick;
+        if (baseline_tick == NO_BASELINE || baseline_tick >= first_tick || !has_frame(baseline_tick)) baseline_tick = NO_BASELINE;
+
+        // The same bytes go to everyone on this baseline; nothing is copied per subscriber
+        const Encoding &encoding = encode(baseline_tick, first_tick);
+        m_socket.send_to(subscriber.address, encoding.bytes, encoding.size);
+
+        m_stats.packets_sent++;
+        m_stats.bytes_sent += encoding.size;
+    }
+}
+
+void SpectatorBroadcaster::poll()
+{
+    if (!is_open()) return;
+
+    receive_messages();
+    if (m_tick_end - m_sent_end >= (uint32_t) BATCH_TICKS && !m_subscribers.empty()) send_batch();
+}
+
+SpectatorBroadcaster::Stats SpectatorBroadcaster::take_stats()
+{
+    Stats stats = m_stats;
+    stats.subscribers = (int) m_subscribers.size();
+    m_stats = Stats();
+    return stats;
+}
+
+SpectatorClient::SpectatorClient() :
+    m_latest_tick(0), m_timeline(0), m_has_frame(false), m_packets_received(0), m_packets_dropped(0)
+{
+    std::fill(m_frame_ticks, m_frame_ticks + HISTORY, NO_BASELINE);
+}
+
+bool SpectatorClient::connect(const char *host, uint16_t port)
+{
+    if (!m_socket.open(0) || !m_socket.set_peer(host, port))
+    {
+        close();
+        return false;
+    }
+
+    start_timeline(0);
+    m_last_packet = Clock::time_point();
+    send_join();
+    return true;
+}
+
+void SpectatorClient::close()
+{
+    m_socket.close();
+}
+
+void SpectatorClient::send_join()
+{
+    uint8_t packet[1] = { JOIN };
+    m_socket.send(packet, sizeof(packet));
+    m_socket.flush();
+    m_last_join = Clock::now();
+}
+
+void SpectatorClient::send_ack(uint32_t tick)
+{
+    uint8_t packet[ACK_SIZE];
+    packet[0] = ACK;
+    packet[1] = m_timeline;
+    write_u32(packet + 2, tick);
+    m_socket.send(packet, sizeof(packet));
+    m_socket.flush();
+}
+
+void SpectatorClient::start_timeline(uint8_t timeline)
+{
+    std::fill(m_frame_ticks, m_frame_ticks + HISTORY, NO_BASELINE);
+    m_latest_tick = 0;
+    m_timeline = timeline;
+    m_has_frame = false;
+}
+
+bool SpectatorClient::decode(const uint8_t *packet, int size)
+{
+    if (size < PACKET_HEADER_SIZE || packet[0] != STATE) return false;
+
+    uint32_t baseline_tick = read_u32(packet + 2),
+             first_tick = read_u32(packet + 6);
+    int count = packet[10];
+
+    // The broadcaster jumped: nothing decoded so far belongs to the new timeline, so none of it may be
+    // shown or used as a baseline again. A packet from before the jump that arrives late is just dropped.
+    int8_t timeline_change = (int8_t) (packet[1] - m_timeline);
+    if (m_has_frame && timeline_change < 0) return false;
+    if (!m_has_frame || timeline_change > 0) start_timeline(packet[1]);
+
+    SpectatorFrame previous;
+    if (baseline_tick != NO_BASELINE && m_frame_ticks[baseline_tick & HISTORY_MASK] == baseline_tick)
+    {
+        previous = m_frames[baseline_tick & HISTORY_MASK];
+    }
+    else if (baseline_tick != NO_BASELINE)
+    {
+        // Whatever this was built on is gone; ask for a packet that needs no baseline
+        m_packets_dropped++;
+        send_ack(NO_BASELINE);
+        return false;
+    }
+
+    int offset = PACKET_HEADER_SIZE;
+    for (int i = 0; i < count; i++)
+    {
+        if (offset >= size) return false;
+
+        uint8_t changed = packet[offset++];
+        int fields[FIELD_COUNT];
+        get_fields(previous, fields);
+        for (int field = 0; field < FIELD_COUNT; field++)
+        {
+            if ((changed & (1 << field)) == 0) continue;
+
+            int delta, used = read_delta(packet + offset, size - offset, delta);
+            if (used == 0) return false;
+            fields[field] += delta;
+            offset += used;
+        }
+        set_fields(previous, fields);
+
+        uint32_t tick = first_tick + i;
+        m_frames[tick & HISTORY_MASK] = previous;
+        m_frame_ticks[tick & HISTORY_MASK] = tick;
+        if (!m_has_frame || tick > m_latest_tick) m_latest_tick = tick;
+        m_has_frame = true;
+    }
+
+    return true;
+}
+
+void SpectatorClient::poll()
+{
+    if (!is_active()) return;
+
+    uint8_t packet[UdpSocket::MAX_PACKET_SIZE];
+    int size;
+    bool has_news = false;
+    while ((size = m_socket.receive(packet, sizeof(packet))) > 0)
+    {
+        m_packets_received++;
+        if (decode(packet, size))
+        {
+            has_news = true;
+            m_last_packet = Clock::now();
+        }
+    }
+
+    if (has_news)
+    {
+        send_ack(m_latest_tick);
+    }
+    else if (Clock::now() - std::max(m_last_join, m_last_packet) >= std::chrono::milliseconds(JOIN_INTERVAL_MS))
+    {
+        // Not heard from the broadcaster in a while: join again, which is harmless if we never left
+        send_join();
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "Match.h"
+#include "UdpSocket.h"
+
+// What a spectator needs to draw one tick of a match, with positions quantised to 1/256 of a unit
+struct SpectatorFrame
+{
+    int16_t ball_x = 0,
+            ball_y = 0,
+            left_paddle_y = 0,
+            right_paddle_y = 0;
+    uint8_t left_score = 0,
+            right_score = 0,
+            phase = PHASE_SERVE;
+
+    bool operator==(const SpectatorFrame &other) const;
+};
+
+SpectatorFrame make_spectator_frame(const Match &match);
+
+// Writes a frame into a match for rendering; everything the frame does not carry is left alone
+void apply_spectator_frame(const SpectatorFrame &frame, Match &match);
+
+// Spectator packets: u8 type, u8 timeline, u32 baseline tick, u32 first tick, u8 count, then one delta per
+// tick. Each delta is a byte flagging which fields changed followed by a zigzag varint per changed field,
+// taken against the previous tick, or against the baseline for the first one. A baseline of NO_BASELINE
+// means the first tick is against an all-zero frame, which any spectator can decode. The timeline moves on
+// whenever the broadcaster's ticks jump (a rewind or a seek), so the same tick number from before the
+// jump is never mistaken for a baseline after it.
+namespace spectator_packet
+{
+    constexpr uint8_t STATE = 'V',
+                      JOIN = 'J',
+                      ACK = 'A';  // u8 type, u8 timeline, u32 newest tick decoded, or NO_BASELINE to ask for a fresh start
+
+    constexpr uint32_t NO_BASELINE = UINT32_MAX;
+
+    // Frames both ends keep for baselines; must stay a power of two
+    constexpr uint32_t HISTORY = 256,
+                       HISTORY_MASK = HISTORY - 1;
+}
+
+// Match side of the stream. Every BATCH_TICKS ticks it sends the new ticks to each subscriber as deltas
+// against the newest tick that subscriber acknowledged. Subscribers that acknowledged the same tick (on a
+// local network that is nearly all of them) share one encoded packet, so the cost of a send grows with
+// the number of distinct baselines rather than the number of spectators.
+class SpectatorBroadcaster
+{
+public:
+    struct Stats
+    {
+        int subscribers = 0;
+        int batches = 0;
+        int encodings = 0;  // packets actually encoded; the rest were reused
+        int packets_sent = 0;
+        long bytes_sent = 0;
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Subscriber
+    {
+        UdpAddress        address;
+        uint32_t          acknowledged_tick;
+        Clock::time_point last_heard;
+    };
+
+    struct Encoding
+    {
+        uint32_t baseline_tick;
+        int      size;
+        uint8_t  bytes[UdpSocket::MAX_PACKET_SIZE];
+    };
+
+    void receive_messages();
+    void send_batch();
+    const Encoding &encode(uint32_t baseline_tick, uint32_t first_tick);
+    bool has_frame(uint32_t tick) const { return m_frame_ticks[tick & spectator_packet::HISTORY_MASK] == tick; };
+
+    UdpSocket m_socket;
+
+    SpectatorFrame m_frames[spectator_packet::HISTORY];
+    uint32_t       m_frame_ticks[spectator_packet::HISTORY];
+    uint32_t       m_tick_end;  // frames are recorded for ticks before this
+    uint32_t       m_sent_end;  // ticks before this have gone out
+    uint8_t        m_timeline;  // bumped on every jump in the ticks recorded
+
+    std::vector<Subscriber> m_subscribers;
+
+    // Encodings made for the current batch, reused for every subscriber sharing a baseline
+    std::vector<Encoding> m_encodings;
+    int                   m_encoding_count;
+
+    Stats m_stats;
+
+public:
+    static constexpr int BATCH_TICKS = 4,
+                         MAX_BATCH_TICKS = 32,  // older unsent ticks are skipped; spectators only need recent ones
+                         MAX_SUBSCRIBERS = 1024,
+                         SUBSCRIBER_TIMEOUT_MS = 5000;
+
+    SpectatorBroadcaster();
+
+    bool open(uint16_t port);
+    void close();
+
+    // Call once per simulated tick. Consecutive tick numbers continue the stream; anything else starts a
+    // new timeline.
+    void record(uint32_t tick, const Match &match);
+
+    // Handles joins and acknowledgements, then sends a batch if enough ticks have built up
+    void poll();
+
+    Stats take_stats();
+
+    bool const is_open() const { return m_socket.is_open(); };
+};
+
+// Spectator side of the stream: joins a broadcaster, decodes its packets into a frame history and
+// acknowledges the newest decoded tick so the next packets can be deltas against it.
+class SpectatorClient
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void send_join();
+    void send_ack(uint32_t tick);
+    void start_timeline(uint8_t timeline);
+    bool decode(const uint8_t *packet, int size);
+
+    UdpSocket m_socket;
+
+    SpectatorFrame m_frames[spectator_packet::HISTORY];
+    uint32_t       m_frame_ticks[spectator_packet::HISTORY];
+    uint32_t       m_latest_tick;
+    uint8_t        m_timeline;
+    bool           m_has_frame;
+
+    Clock::time_point m_last_join;
+    Clock::time_point m_last_packet;
+
+    int m_packets_received;
+    int m_packets_dropped;  // arrived against a baseline that was no longer here
+
+public:
+    static constexpr int JOIN_INTERVAL_MS = 1000;
+
+    SpectatorClient();
+
+    bool connect(const char *host, uint16_t port);
+    void close();
+
+    // Receives and decodes whatever has arrived, and keeps asking to join until the stream starts
+    void poll();
+
+    bool const is_active()              const { return m_socket.is_open(); };
+    bool const has_frame()              const { return m_has_frame;        };
+    uint32_t const get_latest_tick()    const { return m_latest_tick;      };
+    int const get_packets_received()    const { return m_packets_received; };
+    int const get_packets_dropped()     const { return m_packets_dropped;  };
+    const SpectatorFrame &get_latest_frame() const { return m_frames[m_latest_tick & spectator_packet::HISTORY_MASK]; };
+};
@@ -0,0 +1,124 @@
+#define GL_SILENCE_DEPRECATION
+
+#include <algorithm>
+#include "SpriteBatch.h"
+
+namespace
+{
+    constexpr int VERTICES_PER_SPRITE = 6;
+
+    const glm::vec4 QUAD_CORNERS[VERTICES_PER_SPRITE] = {
+        glm::vec4(-0.5f, -0.5f, 0.0f, 1.0f), glm::vec4(0.5f, -0.5f, 0.0f, 1.0f), glm::vec4(0.5f, 0.5f, 0.0f, 1.0f),  // triangle 1
+        glm::vec4(-0.5f, -0.5f, 0.0f, 1.0f), glm::vec4(0.5f, 0.5f, 0.0f, 1.0f), glm::vec4(-0.5f, 0.5f, 0.0f, 1.0f)   // triangle 2
+    };
+
+    const float QUAD_TEXTURE_COORDINATES[VERTICES_PER_SPRITE * 2] = {
+        0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,     // triangle 1
+        0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f,     // triangle 2
+    };
+}
+
+SpriteBatch::SpriteBatch() :
+    m_arena(nullptr), m_vertices(nullptr), m_texture_coordinates(nullptr), m_is_built(false)
+{
+}
+
+void SpriteBatch::begin(FrameArena &arena)
+{
+    m_arena = &arena;
+    m_sprites.clear();
+    m_ranges.clear();
+    m_draws.clear();
+    m_is_built = false;
+}
+
+int SpriteBatch::begin_range()
+{
+    m_ranges.push_back({ (int) m_sprites.size(), 0, 0 });
+    return (int) m_ranges.size() - 1;
+}
+
+void SpriteBatch::add(const glm::mat4 &model_matrix, GLuint texture_id, int layer)
+{
+    if (m_ranges.empty()) begin_range();
+    m_sprites.push_back({ model_matrix, texture_id, layer, (int) m_sprites.size() });
+}
+
+void SpriteBatch::build()
+{
+    m_vertices = m_arena->allocate_array<float>(m_sprites.size() * VERTICES_PER_SPRITE * 2);
+    m_texture_coordinates = m_arena->allocate_array<float>(m_sprites.size() * VERTICES_PER_SPRITE * 2);
+    m_draws.clear();
+
+    for (size_t r = 0; r < m_ranges.size(); r++)
+    {
+        Range &range = m_ranges[r];
+        int last_sprite = r + 1 < m_ranges.size() ? m_ranges[r + 1].first_sprite : (int) m_sprites.size();
+
+        // Layers keep the painter's order; within a layer, equal textures become neighbours
+        std::sort(m_sprites.begin() + range.first_sprite, m_sprites.begin() + last_sprite,
+            [](const Sprite &a, const Sprite &b)
+            {
+                if (a.layer != b.layer)           return a.layer < b.layer;
+                if (a.texture_id != b.texture_id) return a.texture_id < b.texture_id;
+                return a.order < b.order;
+            });
+
+        range.first_draw = (int) m_draws.size();
+
+        for (int s = range.first_sprite; s < last_sprite; s++)
+        {
+            const Sprite &sprite = m_sprites[s];
+            int first_vertex = s * VERTICES_PER_SPRITE;
+
+            if (m_draws.size() > (size_t) range.first_draw && m_draws.back().texture_id == sprite.texture_id)
+            {
+                m_draws.back().vertex_count += VERTICES_PER_SPRITE;
+            }
+            else
+            {
+                m_draws.push_back({ sprite.texture_id, first_vertex, VERTICES_PER_SPRITE });
+            }
+
+            for (int v = 0; v < VERTICES_PER_SPRITE; v++)
+            {
+                glm::vec4 corner = sprite.model_matrix * QUAD_CORNERS[v];
+                m_vertices[(first_vertex + v) * 2]     = corner.x;
+                m_vertices[(first_vertex + v) * 2 + 1] = corner.y;
+                m_texture_coordinates[(first_vertex + v) * 2]     = QUAD_TEXTURE_COORDINATES[v * 2];
+                m_texture_coordinates[(first_vertex + v) * 2 + 1] = QUAD_TEXTURE_COORDINATES[v * 2 + 1];
+            }
+        }
+
+        range.draw_count = (int) m_draws.size() - range.first_draw;
+    }
+
+    m_is_built = true;
+}
+
+void SpriteBatch::draw_range(ShaderProgram &program, int range_index)
+{
+    if (!m_is_built) build();
+    if (range_index < 0 || range_index >= (int) m_ranges.size()) return;
+
+    const Range &range = m_ranges[range_index];
+    if (range.draw_count == 0) return;
+
+    // Vertices are already in world space
+    program.set_model_matrix(glm::mat4(1.0f));
+
+    glVertexAttribPointer(program.get_position_attribute(), 2, GL_FLOAT, false, 0, m_vertices);
+    glEnableVertexAttribArray(program.get_position_attribute());
+
+    glVertexAttribPointer(program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, m_texture_coordinates);
+    glEnableVertexAttribArray(program.get_tex_coordinate_attribute());
+
+    for (int d = range.first_draw; d < range.first_draw + range.draw_count; d++)
+    {
+        glBindTexture(GL_TEXTURE_2D, m_draws[d].texture_id);
+        glDrawArrays(GL_TRIANGLES, m_draws[d].first_vertex, m_draws[d].vertex_count);
+    }
+
+    glDisableVertexAttribArray(program.get_position_attribute());
+    glDisableVertexAttribArray(program.get_tex_coordinate_attribute());
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "FrameArena.h"
+#include "ShaderProgram.h"
+
+// Collects textured quads for a whole frame into one shared vertex stream. Quads are grouped into
+// ranges (one per viewport) and, inside a range, sorted by layer then texture so each range costs one
+// draw call per distinct texture instead of one per sprite. The vertex stream comes from the frame arena
+// passed to begin(), so it stays valid for the rest of the frame and the whole of the next.
+class SpriteBatch
+{
+private:
+    struct Sprite
+    {
+        glm::mat4 model_matrix;
+        GLuint    texture_id;
+        int       layer;
+        int       order;
+    };
+
+    struct Draw
+    {
+        GLuint texture_id;
+        int    first_vertex;
+        int    vertex_count;
+    };
+
+    struct Range
+    {
+        int first_sprite;
+        int first_draw;
+        int draw_count;
+    };
+
+    std::vector<Sprite> m_sprites;
+    std::vector<Range>  m_ranges;
+    std::vector<Draw>   m_draws;
+
+    FrameArena *m_arena;
+    float      *m_vertices;
+    float      *m_texture_coordinates;
+
+    bool m_is_built;
+
+public:
+    SpriteBatch();
+
+    void begin(FrameArena &arena);
+    int  begin_range();
+    void add(const glm::mat4 &model_matrix, GLuint texture_id, int layer);
+
+    // Sorts and expands every queued sprite into the shared vertex stream; called once per frame
+    void build();
+    void draw_range(ShaderProgram &program, int range_index);
+
+    int const get_range_count()  const { return (int) m_ranges.size();  };
+    int const get_sprite_count() const { return (int) m_sprites.size(); };
+    int const get_draw_count()   const { return (int) m_draws.size();   };
+};
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include "SystemScheduler.h"
+
+SystemScheduler::SystemScheduler(ThreadPool *pool) :
+    m_pool(pool), m_current_stage(nullptr)
+{
+    m_stage_job = [this](int begin, int end)
+    {
+        for (int i = begin; i < end; i++) m_systems[(*m_current_stage)[i]].run();
+    };
+}
+
+void SystemScheduler::add_system(const char *name, ComponentMask reads, ComponentMask writes, std::function<void()> run)
+{
+    m_systems.push_back({ name, reads, writes, std::move(run) });
+}
+
+void SystemScheduler::build()
+{
+    m_stages.clear();
+    std::vector<int> stage_of(m_systems.size(), 0);
+
+    for (size_t i = 0; i < m_systems.size(); i++)
+    {
+        const System &system = m_systems[i];
+        for (size_t earlier = 0; earlier < i; earlier++)
+        {
+            const System &other = m_systems[earlier];
+            bool is_conflict = (other.writes & (system.reads | system.writes)) != 0 ||
+                               (other.reads & system.writes) != 0;
+            if (is_conflict) stage_of[i] = std::max(stage_of[i], stage_of[earlier] + 1);
+        }
+
+        if (stage_of[i] >= (int) m_stages.size()) m_stages.resize(stage_of[i] + 1);
+        m_stages[stage_of[i]].push_back((int) i);
+    }
+}
+
+void SystemScheduler::run()
+{
+    for (const std::vector<int> &stage : m_stages)
+    {
+        if (m_pool == nullptr || stage.size() == 1)
+        {
+            for (int index : stage) m_systems[index].run();
+            continue;
+        }
+
+        m_current_stage = &stage;
+        m_pool->parallel_for((int) stage.size(), 1, m_stage_job);
+    }
+    m_current_stage = nullptr;
+}
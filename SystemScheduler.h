@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "ThreadPool.h"
+
+// One bit per piece of shared state (an array of matches, the particle systems, ...). What each bit
+// stands for is up to whoever registers the systems.
+typedef uint64_t ComponentMask;
+
+// Runs a fixed list of game systems once per call to run(). Every system declares the components it
+// reads and the ones it writes. Two systems conflict when either writes something the other touches.
+// build() works out the order once: each system goes in the first stage after every earlier system it
+// conflicts with, so the registration order still settles every conflict. Systems that share a stage
+// run in parallel on the thread pool; the stages run one after another.
+class SystemScheduler
+{
+private:
+    struct System
+    {
+        const char           *name;
+        ComponentMask         reads;
+        ComponentMask         writes;
+        std::function<void()> run;
+    };
+
+    std::vector<System>           m_systems;
+    std::vector<std::vector<int>> m_stages;  // indices into m_systems
+
+    ThreadPool *m_pool;
+
+    // What the pool's workers run: the systems of the stage in progress, by position within it
+    const std::vector<int>         *m_current_stage;
+    std::function<void(int, int)>   m_stage_job;
+
+public:
+    // Without a pool, or with a one-thread pool, every system runs on the caller in stage order
+    explicit SystemScheduler(ThreadPool *pool = nullptr);
+
+    SystemScheduler(const SystemScheduler &) = delete;
+    SystemScheduler &operator=(const SystemScheduler &) = delete;
+
+    // A system must not use the scheduler's pool itself. Adding a system after build() needs another
+    // build().
+    void add_system(const char *name, ComponentMask reads, ComponentMask writes, std::function<void()> run);
+
+    void build();
+    void run();
+
+    void set_pool(ThreadPool *pool) { m_pool = pool; };
+
+    int const get_system_count() const { return (int) m_systems.size(); };
+    int const get_stage_count()  const { return (int) m_stages.size();  };
+};
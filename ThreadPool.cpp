@@ -0,0 +1,78 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int thread_count) :
+    m_job(nullptr), m_count(0), m_chunk_size(1), m_next_begin(0),
+    m_busy_workers(0), m_generation(0), m_is_stopping(false)
+{
+    if (thread_count <= 0) thread_count = std::max((int) std::thread::hardware_concurrency(), 1);
+
+    for (int i = 1; i < thread_count; i++) m_workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_stopping = true;
+    }
+    m_work_ready.notify_all();
+    for (std::thread &worker : m_workers) worker.join();
+}
+
+void ThreadPool::run_chunks()
+{
+    int begin;
+    while ((begin = m_next_begin.fetch_add(m_chunk_size)) < m_count)
+    {
+        (*m_job)(begin, std::min(begin + m_chunk_size, m_count));
+    }
+}
+
+void ThreadPool::worker_loop()
+{
+    uint64_t seen_generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_ready.wait(lock, [&] { return m_is_stopping || m_generation != seen_generation; });
+            if (m_is_stopping) return;
+            seen_generation = m_generation;
+        }
+
+        run_chunks();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy_workers == 0) m_work_done.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(int count, int chunk_size, const std::function<void(int, int)> &job)
+{
+    if (count <= 0) return;
+
+    // Not worth waking anyone for a single chunk
+    if (m_workers.empty() || count <= chunk_size)
+    {
+        job(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_chunk_size = std::max(chunk_size, 1);
+        m_next_begin = 0;
+        m_busy_workers = (int) m_workers.size();
+        m_generation++;
+    }
+    m_work_ready.notify_all();
+
+    run_chunks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_work_done.wait(lock, [&] { return m_busy_workers == 0; });
+    m_job = nullptr;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. parallel_for() splits a range into chunks that
+// the workers and the calling thread pull from a shared counter, and returns once every chunk is done.
+class ThreadPool
+{
+private:
+    void worker_loop();
+    void run_chunks();
+
+    std::vector<std::thread> m_workers;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_work_ready;
+    std::condition_variable m_work_done;
+
+    // The current job; only valid while a parallel_for() is in progress
+    const std::function<void(int, int)> *m_job;
+    int              m_count;
+    int              m_chunk_size;
+    std::atomic<int> m_next_begin;
+
+    int      m_busy_workers;
+    uint64_t m_generation;
+    bool     m_is_stopping;
+
+public:
+    // thread_count counts the caller too; 0 uses every hardware thread
+    explicit ThreadPool(int thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void parallel_for(int count, int chunk_size, const std::function<void(int begin, int end)> &job);
+
+    int const get_thread_count() const { return (int) m_workers.size() + 1; };
+};
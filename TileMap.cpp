@@ -0,0 +1,223 @@
+#define GL_SILENCE_DEPRECATION
+
+#include "TileMap.h"
+
+namespace
+{
+    constexpr int FLOATS_PER_VERTEX = 4,  // x, y, u, v
+                  VERTICES_PER_TILE = 6;
+
+    // Pulls texture coordinates slightly inside each tile so nearest sampling never picks up a neighbour
+    constexpr float TILE_UV_INSET = 0.01f;
+}
+
+TileMap::TileMap() :
+    m_width(0), m_height(0), m_tile_size(1.0f),
+    m_tileset_columns(1), m_tileset_rows(1), m_tileset_texture_id(0),
+    m_chunk_columns(0), m_chunk_rows(0)
+{
+}
+
+bool TileMap::load(const char *map_filepath)
+{
+    std::ifstream infile(map_filepath);
+
+    if (infile.fail())
+    {
+        std::cout << "Error opening tile map file:" << map_filepath << std::endl;
+        return false;
+    }
+
+    destroy();
+
+    std::string legend;
+    std::string line;
+    while (std::getline(infile, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+
+        if      (key == "tileset")   fields >> m_tileset_filepath >> m_tileset_columns >> m_tileset_rows;
+        else if (key == "legend")    fields >> legend;
+        else if (key == "tile_size") fields >> m_tile_size;
+        else if (key == "size")      fields >> m_width >> m_height;
+        else if (key == "map")       break;
+    }
+
+    if (m_width <= 0 || m_height <= 0 || legend.empty())
+    {
+        std::cout << "Tile map is missing its size or legend:" << map_filepath << std::endl;
+        return false;
+    }
+
+    m_tiles.assign(m_width * m_height, 0);
+    for (int y = 0; y < m_height && std::getline(infile, line); y++)
+    {
+        for (int x = 0; x < m_width && x < (int) line.size(); x++)
+        {
+            size_t tile = legend.find(line[x]);
+            m_tiles[y * m_width + x] = tile == std::string::npos ? 0 : (unsigned char) tile;
+        }
+    }
+
+    m_chunk_columns = (m_width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    m_chunk_rows    = (m_height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    m_chunks.assign(m_chunk_columns * m_chunk_rows, { 0, 0, true });
+
+    return true;
+}
+
+bool TileMap::reload(const char *map_filepath)
+{
+    TileMap edited;
+    if (!edited.load(map_filepath)) return false;
+
+    bool is_same_layout = edited.m_width == m_width && edited.m_height == m_height &&
+                          edited.m_tile_size == m_tile_size &&
+                          edited.m_tileset_columns == m_tileset_columns && edited.m_tileset_rows == m_tileset_rows;
+    if (!is_same_layout)
+    {
+        // Every chunk moves, so start over; the new chunks have no buffers yet and are all dirty
+        GLuint texture_id = m_tileset_texture_id;
+        destroy();
+        *this = edited;
+        m_tileset_texture_id = texture_id;
+        return true;
+    }
+
+    m_tileset_filepath = edited.m_tileset_filepath;
+    for (int y = 0; y < m_height; y++)
+    {
+        for (int x = 0; x < m_width; x++) set_tile(x, y, edited.m_tiles[y * m_width + x]);
+    }
+    return true;
+}
+
+void TileMap::destroy()
+{
+    for (Chunk &chunk : m_chunks)
+    {
+        if (chunk.vertex_buffer != 0) glDeleteBuffers(1, &chunk.vertex_buffer);
+    }
+    m_chunks.clear();
+}
+
+void TileMap::set_tile(int x, int y, unsigned char tile)
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return;
+    if (m_tiles[y * m_width + x] == tile) return;
+
+    m_tiles[y * m_width + x] = tile;
+    mark_dirty(x, y);
+}
+
+int TileMap::get_tile(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) return -1;
+    return m_tiles[y * m_width + x];
+}
+
+void TileMap::mark_dirty(int x, int y)
+{
+    m_chunks[(y / CHUNK_SIZE) * m_chunk_columns + x / CHUNK_SIZE].is_dirty = true;
+}
+
+void TileMap::build_chunk(int chunk_index)
+{
+    Chunk &chunk = m_chunks[chunk_index];
+    int first_x = (chunk_index % m_chunk_columns) * CHUNK_SIZE,
+        first_y = (chunk_index / m_chunk_columns) * CHUNK_SIZE;
+
+    float tile_u = 1.0f / m_tileset_columns,
+          tile_v = 1.0f / m_tileset_rows;
+
+    // The map is centred on the origin with row 0 at the top
+    float left = -m_width * m_tile_size / 2.0f,
+          top  =  m_height * m_tile_size / 2.0f;
+
+    std::vector<float> vertices;
+    vertices.reserve(CHUNK_SIZE * CHUNK_SIZE * VERTICES_PER_TILE * FLOATS_PER_VERTEX);
+
+    for (int y = first_y; y < first_y + CHUNK_SIZE && y < m_height; y++)
+    {
+        for (int x = first_x; x < first_x + CHUNK_SIZE && x < m_width; x++)
+        {
+            int tile = m_tiles[y * m_width + x];
+
+            float x0 = left + x * m_tile_size, x1 = x0 + m_tile_size,
+                  y1 = top - y * m_tile_size,  y0 = y1 - m_tile_size;
+
+            float u0 = ((tile % m_tileset_columns) + TILE_UV_INSET) * tile_u,
+                  u1 = ((tile % m_tileset_columns) + 1.0f - TILE_UV_INSET) * tile_u,
+                  v0 = ((tile / m_tileset_columns) + TILE_UV_INSET) * tile_v,
+                  v1 = ((tile / m_tileset_columns) + 1.0f - TILE_UV_INSET) * tile_v;
+
+            // Same winding and orientation as the sprite quads: v grows downwards in the image
+            float quad[VERTICES_PER_TILE * FLOATS_PER_VERTEX] = {
+                x0, y0, u0, v1,   x1, y0, u1, v1,   x1, y1, u1, v0,  // triangle 1
+                x0, y0, u0, v1,   x1, y1, u1, v0,   x0, y1, u0, v0   // triangle 2
+            };
+            vertices.insert(vertices.end(), quad, quad + VERTICES_PER_TILE * FLOATS_PER_VERTEX);
+        }
+    }
+
+    if (chunk.vertex_buffer == 0) glGenBuffers(1, &chunk.vertex_buffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    chunk.vertex_count = (int) vertices.size() / FLOATS_PER_VERTEX;
+    chunk.is_dirty = false;
+}
+
+void TileMap::rebuild_dirty_chunks()
+{
+    for (size_t i = 0; i < m_chunks.size(); i++)
+    {
+        if (m_chunks[i].is_dirty) build_chunk((int) i);
+    }
+}
+
+void TileMap::render(ShaderProgram &program, const Camera &camera)
+{
+    rebuild_dirty_chunks();
+
+    program.set_model_matrix(glm::mat4(1.0f));
+    glBindTexture(GL_TEXTURE_2D, m_tileset_texture_id);
+
+    glEnableVertexAttribArray(program.get_position_attribute());
+    glEnableVertexAttribArray(program.get_tex_coordinate_attribute());
+
+    float chunk_extent = CHUNK_SIZE * m_tile_size;
+    glm::vec3 half_extents = glm::vec3(chunk_extent, chunk_extent, 0.0f) / 2.0f;
+
+    for (size_t i = 0; i < m_chunks.size(); i++)
+    {
+        int column = (int) i % m_chunk_columns,
+            row    = (int) i / m_chunk_columns;
+
+        // Edge chunks are treated as full size; the slack only makes culling slightly conservative
+        glm::vec3 centre = glm::vec3(
+            -m_width * m_tile_size / 2.0f + (column + 0.5f) * chunk_extent,
+             m_height * m_tile_size / 2.0f - (row + 0.5f) * chunk_extent,
+            0.0f);
+        if (!camera.is_visible(centre, half_extents)) continue;
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_chunks[i].vertex_buffer);
+        glVertexAttribPointer(program.get_position_attribute(), 2, GL_FLOAT, false,
+            FLOATS_PER_VERTEX * sizeof(float), (void *) 0);
+        glVertexAttribPointer(program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false,
+            FLOATS_PER_VERTEX * sizeof(float), (void *) (2 * sizeof(float)));
+        glDrawArrays(GL_TRIANGLES, 0, m_chunks[i].vertex_count);
+    }
+
+    // Everything else in the renderer uses client-side arrays, which need no buffer bound
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glDisableVertexAttribArray(program.get_position_attribute());
+    glDisableVertexAttribArray(program.get_tex_coordinate_attribute());
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <string>
+#include <vector>
+#include "glm/vec3.hpp"
+#include "ShaderProgram.h"
+#include "Camera.h"
+
+// A grid of tiles drawn from a small tileset texture. The map is split into square chunks, each with
+// a static vertex buffer built once and rebuilt only when one of its tiles changes.
+class TileMap
+{
+private:
+    struct Chunk
+    {
+        GLuint vertex_buffer;
+        int    vertex_count;
+        bool   is_dirty;
+    };
+
+    void build_chunk(int chunk_index);
+    void mark_dirty(int x, int y);
+
+    int   m_width;
+    int   m_height;
+    float m_tile_size;
+
+    std::string m_tileset_filepath;
+    int         m_tileset_columns;
+    int         m_tileset_rows;
+    GLuint      m_tileset_texture_id;
+
+    std::vector<unsigned char> m_tiles;
+
+    int m_chunk_columns;
+    int m_chunk_rows;
+    std::vector<Chunk> m_chunks;
+
+public:
+    static constexpr int CHUNK_SIZE = 8;
+
+    TileMap();
+
+    // Reads a .court file; the tileset texture is loaded separately by the caller
+    bool load(const char *map_filepath);
+
+    // Reads the file again after it has been edited. When the layout is unchanged only the tiles that
+    // differ are set, so only their chunks are rebuilt. The tileset texture is kept; the caller checks
+    // get_tileset_filepath() for a new one. Returns false, with the map untouched, if the file is bad.
+    bool reload(const char *map_filepath);
+
+    void set_tileset_texture(GLuint texture_id) { m_tileset_texture_id = texture_id; };
+
+    void set_tile(int x, int y, unsigned char tile);
+    int  get_tile(int x, int y) const;
+
+    void rebuild_dirty_chunks();
+    void render(ShaderProgram &program, const Camera &camera);
+    void destroy();
+
+    const std::string &get_tileset_filepath() const { return m_tileset_filepath;   };
+    GLuint const get_tileset_texture()         const { return m_tileset_texture_id; };
+    int   const get_width()     const { return m_width;     };
+    int   const get_height()    const { return m_height;    };
+    float const get_tile_size() const { return m_tile_size; };
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+/* Plain C interface to TrainingEnvironment, for binding from Python (ctypes, cffi) or any other language
+   with a C foreign-function interface. The TrainingLibrary project in the solution builds it as a DLL
+   from TrainingEnvironment.cpp, BatchSimulator.cpp and ThreadPool.cpp with TRAINING_API_EXPORTS defined;
+   nothing else is needed, SDL and OpenGL included. Elsewhere the same three files make a shared object:
+
+       g++ -std=c++14 -O2 -ffp-contract=off -shared -fPIC -fvisibility=hidden -pthread -o libtraining.so \
+           TrainingEnvironment.cpp BatchSimulator.cpp ThreadPool.cpp
+
+   Every other caller includes this header as it is.
+
+   The caller owns every buffer: observations holds env_count * training_observation_size() floats,
+   rewards env_count floats, terminated and truncated env_count bytes each. reset and step write into
+   them directly, so a trainer can hand the library the memory behind its own arrays. */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(TRAINING_API_EXPORTS)
+#define TRAINING_API __declspec(dllexport)
+#else
+#define TRAINING_API
+#endif
+#else
+#define TRAINING_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct TrainingHandle TrainingHandle;
+
+/* Returns null if env_count is not positive. frame_skip below 1 counts as 1; max_episode_ticks 0 never
+   truncates. */
+TRAINING_API TrainingHandle *training_create(int32_t env_count, int32_t frame_skip, int32_t auto_reset,
+                                             int32_t max_episode_ticks);
+TRAINING_API void training_destroy(TrainingHandle *handle);
+
+TRAINING_API int32_t training_observation_size(void);
+TRAINING_API int32_t training_action_count(void);
+TRAINING_API int32_t training_env_count(const TrainingHandle *handle);
+
+/* rewards, terminated and truncated may be null */
+TRAINING_API void training_bind(TrainingHandle *handle, float *observations, float *rewards,
+                                uint8_t *terminated, uint8_t *truncated);
+
+TRAINING_API void training_reset(TrainingHandle *handle);
+TRAINING_API void training_reset_env(TrainingHandle *handle, int32_t env_index);
+
+/* actions holds env_count values, each 0 (stay), 1 (up) or 2 (down) */
+TRAINING_API void training_step(TrainingHandle *handle, const int32_t *actions);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include "TrainingApi.h"
+#include "TrainingEnvironment.h"
+
+namespace
+{
+    int action_direction(int32_t action) { return action == 1 ? 1 : action == 2 ? -1 : 0; }
+}
+
+TrainingEnvironment::TrainingEnvironment(int env_count, const TrainingSettings &settings) :
+    m_simulator(std::max(env_count, 0)), m_settings(settings),
+    m_observations(nullptr), m_rewards(nullptr), m_terminated(nullptr), m_truncated(nullptr)
+{
+    m_settings.frame_skip = std::max(m_settings.frame_skip, 1);
+    m_settings.max_episode_ticks = std::max(m_settings.max_episode_ticks, 0);
+
+    int count = m_simulator.get_count();
+    m_spare_rewards.assign(count, 0.0f);
+    m_spare_terminated.assign(count, 0);
+    m_spare_truncated.assign(count, 0);
+    m_episode_ticks.assign(count, 0);
+    m_score_difference.assign(count, 0.0f);
+    m_is_finished.assign(count, 0);
+
+    // Until the caller binds its own buffers, steps still run and their results go nowhere
+    bind(nullptr, nullptr, nullptr, nullptr);
+}
+
+void TrainingEnvironment::bind(float *observations, float *rewards, uint8_t *terminated, uint8_t *truncated)
+{
+    m_observations = observations;
+    m_rewards = rewards != nullptr ? rewards : m_spare_rewards.data();
+    m_terminated = terminated != nullptr ? terminated : m_spare_terminated.data();
+    m_truncated = truncated != nullptr ? truncated : m_spare_truncated.data();
+}
+
+void TrainingEnvironment::write_observation(int env_index)
+{
+    if (m_observations == nullptr) return;
+
+    const float *phase = m_simulator.get_phase();
+    float speed = m_simulator.get_ball_speed()[env_index] / INIT_BALL_SPEED;
+    float *observation = m_observations + (size_t) env_index * OBSERVATION_SIZE;
+
+    observation[0] = m_simulator.get_ball_x()[env_index] / COURT_HALF_WIDTH;
+    observation[1] = m_simulator.get_ball_y()[env_index] / WALL_Y;
+    observation[2] = m_simulator.get_ball_dx()[env_index] * speed;
+    observation[3] = m_simulator.get_ball_dy()[env_index] * speed;
+    observation[4] = m_simulator.get_left_y()[env_index] / PADDLE_TRAVEL_TOP;
+    observation[5] = m_simulator.get_right_y()[env_index] / PADDLE_TRAVEL_TOP;
+    observation[6] = phase[env_index] == (float) PHASE_RALLY ? 1.0f : 0.0f;
+    observation[7] = m_score_difference[env_index] / POINTS_TO_WIN;
+}
+
+void TrainingEnvironment::reset()
+{
+    for (int i = 0; i < get_env_count(); i++) reset_environment(i);
+}
+
+void TrainingEnvironment::reset_environment(int env_index)
+{
+    m_simulator.reset_match(env_index);
+    m_episode_ticks[env_index] = 0;
+    m_score_difference[env_index] = 0.0f;
+    m_is_finished[env_index] = 0;
+    write_observation(env_index);
+}
+
+void TrainingEnvironment::step(const int32_t *actions)
+{
+    const int count = get_env_count();
+    const float *left_score = m_simulator.get_left_score(),
+                *right_score = m_simulator.get_right_score(),
+                *phase = m_simulator.get_phase();
+
+    std::fill(m_rewards, m_rewards + count, 0.0f);
+    std::fill(m_terminated, m_terminated + count, 0);
+    std::fill(m_truncated, m_truncated + count, 0);
+
+    for (int tick = 0; tick < m_settings.frame_skip; tick++)
+    {
+        // Serving straight away keeps the agent from having to learn when to serve
+        m_simulator.track_ball(0, count);
+        for (int i = 0; i < count; i++) m_simulator.set_left_input(i, action_direction(actions[i]));
+        m_simulator.step(0, count, true, m_settings.delta_time);
+
+        for (int i = 0; i < count; i++)
+        {
+            // A finished environment keeps being stepped with the rest but counts for nothing until it
+            // is reset; its observation stays the one it finished on
+            if (m_is_finished[i]) continue;
+
+            float score_difference = left_score[i] - right_score[i];
+            m_rewards[i] += score_difference - m_score_difference[i];
+            m_score_difference[i] = score_difference;
+            m_episode_ticks[i]++;
+
+            if (phase[i] == (float) PHASE_MATCH_OVER) m_terminated[i] = 1;
+            else if (m_settings.max_episode_ticks > 0 && m_episode_ticks[i] >= m_settings.max_episode_ticks) m_truncated[i] = 1;
+            else continue;
+
+            m_is_finished[i] = 1;
+            write_observation(i);
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!m_is_finished[i]) write_observation(i);
+        else if (m_settings.auto_reset) reset_environment(i);
+    }
+}
+
+/* C interface */
+
+struct TrainingHandle
+{
+    TrainingEnvironment environment;
+
+    TrainingHandle(int env_count, const TrainingSettings &settings) : environment(env_count, settings) {}
+};
+
+TrainingHandle *training_create(int32_t env_count, int32_t frame_skip, int32_t auto_reset, int32_t max_episode_ticks)
+{
+    if (env_count <= 0) return nullptr;
+
+    TrainingSettings settings;
+    settings.frame_skip = frame_skip;
+    settings.auto_reset = auto_reset != 0;
+    settings.max_episode_ticks = max_episode_ticks;
+    return new TrainingHandle(env_count, settings);
+}
+
+void training_destroy(TrainingHandle *handle)
+{
+    delete handle;
+}
+
+int32_t training_observation_size(void)
+{
+    return TrainingEnvironment::OBSERVATION_SIZE;
+}
+
+int32_t training_action_count(void)
+{
+    return TrainingEnvironment::ACTION_COUNT;
+}
+
+int32_t training_env_count(const TrainingHandle *handle)
+{
+    return handle->environment.get_env_count();
+}
+
+void training_bind(TrainingHandle *handle, float *observations, float *rewards, uint8_t *terminated, uint8_t *truncated)
+{
+    handle->environment.bind(observations, rewards, terminated, truncated);
+}
+
+void training_reset(TrainingHandle *handle)
+{
+    handle->environment.reset();
+}
+
+void training_reset_env(TrainingHandle *handle, int32_t env_index)
+{
+    handle->environment.reset_environment(env_index);
+}
+
+void training_step(TrainingHandle *handle, const int32_t *actions)
+{
+    handle->environment.step(actions);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "BatchSimulator.h"
+
+// A vector of matches for training paddle agents, in the shape reinforcement-learning libraries expect:
+// reset() starts every episode, step() takes one action per environment and writes observations,
+// rewards and episode-end flags straight into arrays the caller owns. The agent plays the left paddle
+// and track_ball() plays the right. An episode is one match, worth +1 for every point the agent wins
+// and -1 for every point it loses. The matches run on a BatchSimulator, so a step costs a few
+// nanoseconds per environment.
+//
+// TrainingApi.h wraps this class in plain C functions for trainers written in other languages.
+struct TrainingSettings
+{
+    int   frame_skip = 1;         // ticks each action is repeated for; rewards add up over them
+    bool  auto_reset = true;      // a finished environment starts its next episode straight away
+    int   max_episode_ticks = 0;  // ends an episode early as truncated; 0 never does
+    float delta_time = 0.008f;
+};
+
+class TrainingEnvironment
+{
+public:
+    // Per environment: ball x and y, ball velocity x and y, own paddle y, opponent paddle y, 1 while the
+    // ball is in play, and the score difference. Positions are scaled to about -1..1 and the velocity
+    // to 1 at serve speed.
+    static constexpr int OBSERVATION_SIZE = 8;
+
+    // 0 holds still, 1 moves up, 2 moves down
+    static constexpr int ACTION_COUNT = 3;
+
+private:
+    void write_observation(int env_index);
+
+    BatchSimulator   m_simulator;
+    TrainingSettings m_settings;
+
+    // Caller's buffers: env count times OBSERVATION_SIZE floats, then one value per environment
+    float   *m_observations;
+    float   *m_rewards;
+    uint8_t *m_terminated;
+    uint8_t *m_truncated;
+
+    // Stand-ins for the buffers the caller did not bind
+    std::vector<float>   m_spare_rewards;
+    std::vector<uint8_t> m_spare_terminated, m_spare_truncated;
+
+    // Per environment
+    std::vector<int>     m_episode_ticks;
+    std::vector<float>   m_score_difference;  // left minus right at the end of the last step
+    std::vector<uint8_t> m_is_finished;       // ended and waiting for reset_environment()
+
+public:
+    explicit TrainingEnvironment(int env_count, const TrainingSettings &settings = TrainingSettings());
+
+    // Where reset() and step() write; call it again if the buffers move. Any of them may be null when the
+    // caller does not want them, and nothing is written until this is called.
+    void bind(float *observations, float *rewards, uint8_t *terminated, uint8_t *truncated);
+
+    // Starts a new episode in every environment and writes the first observations
+    void reset();
+
+    // Starts a new episode in one environment; for finished ones when auto_reset is off
+    void reset_environment(int env_index);
+
+    // actions holds one ACTION_COUNT value per environment. With auto_reset, an environment that
+    // finishes reports terminated or truncated along with its final reward, and its observation is
+    // already the first of the next episode.
+    void step(const int32_t *actions);
+
+    int const get_env_count() const { return m_simulator.get_count(); };
+    const TrainingSettings &get_settings() const { return m_settings; };
+};
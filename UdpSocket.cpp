@@ -0,0 +1,224 @@
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #ifdef _MSC_VER
+        #pragma comment(lib, "Ws2_32.lib")
+    #endif
+    typedef SOCKET SocketHandle;
+    typedef int socklen_t;
+#else
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+    typedef int SocketHandle;
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "UdpSocket.h"
+
+namespace
+{
+    sockaddr_in make_address(uint32_t host, uint16_t port)
+    {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = host;
+        address.sin_port = port;
+        return address;
+    }
+}
+
+UdpSocket::UdpSocket() :
+    m_socket(INVALID_SOCKET_HANDLE), m_peer_host(0), m_peer_port(0), m_has_peer(false),
+    m_latency_ms(0), m_jitter_ms(0), m_loss(0.0f),
+    m_random(0x5EED)
+{
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+}
+
+bool UdpSocket::open(uint16_t port)
+{
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    {
+        std::cout << "Unable to start Winsock" << std::endl;
+        return false;
+    }
+#endif
+
+    SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    m_socket = (uintptr_t) handle;
+    if (handle == (SocketHandle) -1)
+    {
+        m_socket = INVALID_SOCKET_HANDLE;
+        std::cout << "Unable to create UDP socket" << std::endl;
+        return false;
+    }
+
+    sockaddr_in address = make_address(htonl(INADDR_ANY), htons(port));
+    if (bind(handle, (const sockaddr *) &address, sizeof(address)) != 0)
+    {
+        std::cout << "Unable to bind UDP port " << port << std::endl;
+        close();
+        return false;
+    }
+
+#ifdef _WIN32
+    u_long is_non_blocking = 1;
+    ioctlsocket(handle, FIONBIO, &is_non_blocking);
+#else
+    fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    return true;
+}
+
+bool UdpSocket::resolve(const char *host, uint16_t port, UdpAddress &address)
+{
+    in_addr host_address;
+    if (inet_pton(AF_INET, host, &host_address) != 1)
+    {
+        std::cout << "Not an IPv4 address: " << host << std::endl;
+        return false;
+    }
+
+    address.host = host_address.s_addr;
+    address.port = htons(port);
+    return true;
+}
+
+bool UdpSocket::set_peer(const char *host, uint16_t port)
+{
+    UdpAddress peer;
+    m_has_peer = resolve(host, port, peer);
+    m_peer_host = peer.host;
+    m_peer_port = peer.port;
+    return m_has_peer;
+}
+
+void UdpSocket::set_buffer_size(int bytes)
+{
+    if (!is_open()) return;
+
+    setsockopt((SocketHandle) m_socket, SOL_SOCKET, SO_RCVBUF, (const char *) &bytes, sizeof(bytes));
+    setsockopt((SocketHandle) m_socket, SOL_SOCKET, SO_SNDBUF, (const char *) &bytes, sizeof(bytes));
+}
+
+void UdpSocket::close()
+{
+    if (!is_open()) return;
+
+#ifdef _WIN32
+    closesocket((SocketHandle) m_socket);
+    WSACleanup();
+#else
+    ::close((SocketHandle) m_socket);
+#endif
+    m_socket = INVALID_SOCKET_HANDLE;
+    m_delayed_packets.clear();
+}
+
+void UdpSocket::set_conditions(int latency_ms, int jitter_ms, float loss)
+{
+    m_latency_ms = std::max(latency_ms, 0);
+    m_jitter_ms = std::max(jitter_ms, 0);
+    m_loss = std::min(std::max(loss, 0.0f), 1.0f);
+}
+
+void UdpSocket::send(const uint8_t *data, int size)
+{
+    if (!is_open() || !m_has_peer) return;
+
+    if (m_loss > 0.0f && std::uniform_real_distribution<float>(0.0f, 1.0f)(m_random) < m_loss) return;
+
+    if (m_latency_ms == 0 && m_jitter_ms == 0)
+    {
+        send_now(data, size);
+        return;
+    }
+
+    int delay_ms = m_latency_ms;
+    if (m_jitter_ms > 0) delay_ms += std::uniform_int_distribution<int>(-m_jitter_ms, m_jitter_ms)(m_random);
+
+    DelayedPacket packet;
+    packet.send_time = Clock::now() + std::chrono::milliseconds(std::max(delay_ms, 0));
+    packet.data.assign(data, data + size);
+    m_delayed_packets.push_back(packet);
+}
+
+void UdpSocket::flush()
+{
+    Clock::time_point now = Clock::now();
+
+    // Jitter can let a later packet overtake an earlier one, just as on a real network
+    for (size_t i = 0; i < m_delayed_packets.size();)
+    {
+        if (m_delayed_packets[i].send_time <= now)
+        {
+            send_now(m_delayed_packets[i].data.data(), (int) m_delayed_packets[i].data.size());
+            m_delayed_packets[i] = m_delayed_packets.back();
+            m_delayed_packets.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void UdpSocket::send_now(const uint8_t *data, int size)
+{
+    sockaddr_in peer_address = make_address(m_peer_host, m_peer_port);
+    sendto((SocketHandle) m_socket, (const char *) data, size, 0, (const sockaddr *) &peer_address, sizeof(peer_address));
+}
+
+void UdpSocket::send_to(const UdpAddress &address, const uint8_t *data, int size)
+{
+    if (!is_open()) return;
+
+    sockaddr_in destination = make_address(address.host, address.port);
+    sendto((SocketHandle) m_socket, (const char *) data, size, 0, (const sockaddr *) &destination, sizeof(destination));
+}
+
+int UdpSocket::receive_from(uint8_t *buffer, int capacity, UdpAddress &sender)
+{
+    if (!is_open()) return 0;
+
+    sockaddr_in sender_address;
+    socklen_t sender_size = sizeof(sender_address);
+    int size = (int) recvfrom((SocketHandle) m_socket, (char *) buffer, capacity, 0, (sockaddr *) &sender_address, &sender_size);
+    if (size <= 0) return 0;
+
+    sender.host = sender_address.sin_addr.s_addr;
+    sender.port = sender_address.sin_port;
+    return size;
+}
+
+int UdpSocket::receive(uint8_t *buffer, int capacity)
+{
+    if (!is_open()) return 0;
+
+    while (true)
+    {
+        sockaddr_in sender;
+        socklen_t sender_size = sizeof(sender);
+        int size = (int) recvfrom((SocketHandle) m_socket, (char *) buffer, capacity, 0, (sockaddr *) &sender, &sender_size);
+        if (size <= 0) return 0;
+
+        // Anything not from the peer is ignored
+        if (!m_has_peer || (sender.sin_addr.s_addr == m_peer_host && sender.sin_port == m_peer_port))
+        {
+            return size;
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// IPv4 endpoint, both fields in network byte order
+struct UdpAddress
+{
+    uint32_t host = 0;
+    uint16_t port = 0;
+
+    bool operator==(const UdpAddress &other) const { return host == other.host && port == other.port; }
+};
+
+// Non-blocking IPv4 UDP socket, usually talking to a single peer. Outgoing packets can be run through a simple
+// link conditioner that delays, jitters and drops them, so bad networks can be reproduced over loopback.
+class UdpSocket
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct DelayedPacket
+    {
+        Clock::time_point    send_time;
+        std::vector<uint8_t> data;
+    };
+
+    void send_now(const uint8_t *data, int size);
+
+    // Kept as plain integers so the platform socket headers stay out of everything that includes this
+    static constexpr uintptr_t INVALID_SOCKET_HANDLE = ~(uintptr_t) 0;
+
+    uintptr_t m_socket;
+    uint32_t  m_peer_host;  // network byte order
+    uint16_t  m_peer_port;  // network byte order
+    bool      m_has_peer;
+
+    int   m_latency_ms;
+    int   m_jitter_ms;
+    float m_loss;
+
+    std::vector<DelayedPacket> m_delayed_packets;
+    std::mt19937               m_random;
+
+public:
+    static constexpr int MAX_PACKET_SIZE = 1200;
+
+    UdpSocket();
+    ~UdpSocket();
+
+    // Binds to every interface on the given port
+    bool open(uint16_t port);
+    bool set_peer(const char *host, uint16_t port);
+    void close();
+
+    // Asks the OS for bigger send and receive buffers, for sockets that serve many peers at once
+    void set_buffer_size(int bytes);
+
+    // latency and jitter in milliseconds, loss as a fraction between 0 and 1
+    void set_conditions(int latency_ms, int jitter_ms, float loss);
+
+    void send(const uint8_t *data, int size);
+
+    // Hands any conditioned packets that are now due to the OS
+    void flush();
+
+    // Returns the size of the next waiting packet from the peer, or 0 if there is none
+    int receive(uint8_t *buffer, int capacity);
+
+    // Many-peer use: sends straight to the given address, skipping the link conditioner, and receives
+    // from anyone, reporting who sent it
+    void send_to(const UdpAddress &address, const uint8_t *data, int size);
+    int receive_from(uint8_t *buffer, int capacity, UdpAddress &sender);
+
+    static bool resolve(const char *host, uint16_t port, UdpAddress &address);
+
+    bool const is_open() const { return m_socket != INVALID_SOCKET_HANDLE; };
+};
@@ -17,9 +17,35 @@
 
 #include <SDL.h>
 #include <SDL_opengl.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <vector>
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "BatchSimulator.h"
+#include "Camera.h"
+#include "ContactQueue.h"
+#include "ControllerSampler.h"
+#include "DebugDraw.h"
+#include "FrameArena.h"
+#include "InputLog.h"
+#include "InputQueue.h"
+#include "MatchServer.h"
+#include "Match.h"
+#include "ObjectPool.h"
+#include "ParticleSystem.h"
+#include "PostProcessor.h"
+#include "RollbackSession.h"
+#include "SnapshotRing.h"
+#include "SpectatorStream.h"
+#include "SpriteBatch.h"
+#include "SystemScheduler.h"
+#include "TileMap.h"
 #include "stb_image.h"
 
 enum AppStatus { RUNNING, TERMINATED };
@@ -32,80 +58,288 @@ BG_GREEN = 0.0f,
 BG_BLUE = 0.0f,
 BG_OPACITY = 1.0f;
 
-constexpr int VIEWPORT_X = 0,
-VIEWPORT_Y = 0,
-VIEWPORT_WIDTH = WINDOW_WIDTH,
-VIEWPORT_HEIGHT = WINDOW_HEIGHT;
-
 constexpr char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
-F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
+F_SHADER_PATH[] = "shaders/fragment_textured.glsl",
+V_PARTICLE_SHADER_PATH[] = "shaders/vertex_particle.glsl",
+F_PARTICLE_SHADER_PATH[] = "shaders/fragment_particle.glsl",
+V_DEBUG_SHADER_PATH[] = "shaders/vertex.glsl",
+F_DEBUG_SHADER_PATH[] = "shaders/fragment.glsl";
 
 constexpr float MILLISECONDS_IN_SECOND = 1000.0f;
 
+// The matches advance in fixed 8 ms ticks (125 Hz) whatever the frame rate. A frame that falls further
+// behind than MAX_TICKS_PER_FRAME drops the backlog instead of trying to catch up.
+constexpr Uint32 FIXED_TIMESTEP_MS = 8;
+constexpr int MAX_TICKS_PER_FRAME = 8;
+
+// Every tick is snapshotted; R rewinds the matches by REWIND_TICKS (two seconds)
+constexpr int SNAPSHOT_HISTORY_TICKS = 512,
+REWIND_TICKS = 250;
+
+// During a replay , and . jump back and forward by REPLAY_SEEK_TICKS (five seconds)
+constexpr int REPLAY_SEEK_TICKS = 625;
+
+// Networked play prints its rollback cost this often
+constexpr Uint32 NET_STATS_INTERVAL_MS = 1000;
+
+// Longest an idle loop sleeps without an event before running a frame and checking again. Every input
+// wakes it with an event, the controller sampler's snapshots included, so this only bounds how long a
+// missed wake-up can leave the screen stale.
+constexpr int IDLE_WAIT_TIMEOUT_MS = 250;
+
 constexpr GLint NUMBER_OF_TEXTURES = 1,
 LEVEL_OF_DETAIL = 0,
 TEXTURE_BORDER = 0;
 
 constexpr char BALL_SPRITE_FILEPATH[] = "Ball.png";
-constexpr char COURT_SPRITE_FILEPATH[] = "Court.png";
+constexpr char DEFAULT_COURT_FILEPATH[] = "assets/courts/grass.court";
 constexpr char MARIO_SPRITE_FILEPATH[] = "Mario.png";
 constexpr char LUIGI_SPRITE_FILEPATH[] = "Luigi.png";
-constexpr glm::vec3 INIT_SCALE = glm::vec3(12.0f, 11.0f, 0.0f);
-constexpr glm::vec3 INIT_PLAYER_1_SCALE = glm::vec3(0.8f, 1.2f, 0.0f);
-constexpr glm::vec3 INIT_PLAYER_2_SCALE = glm::vec3(1.0f, 1.0f, 0.0f);
-constexpr glm::vec3 INIT_BALL_SCALE = glm::vec3(0.25f, 0.25f, 0.0f);
+constexpr char PLAYER_1_WINS_FILEPATH[] = "assets/player1_wins.png";
+constexpr char PLAYER_2_WINS_FILEPATH[] = "assets/player2_wins.png";
+
+// One small ball per point, growing outward from the centre line along the top of the court
+constexpr glm::vec3 SCORE_PIP_SCALE = glm::vec3(0.2f, 0.2f, 0.0f),
+WIN_BANNER_SCALE = glm::vec3(6.0f, 0.75f, 0.0f);
+constexpr float SCORE_PIP_Y = 3.1f,
+SCORE_PIP_START_X = 0.5f,
+SCORE_PIP_SPACING = 0.3f;
+
+constexpr float ORTHO_HALF_WIDTH = 5.0f,
+ORTHO_HALF_HEIGHT = 3.75f;
+
+// Pixel mode renders into this fixed target and upscales it by a whole number to the window
+constexpr int LOW_RES_WIDTH = 320,
+LOW_RES_HEIGHT = 240;
+constexpr float LOW_RES_PIXELS_PER_UNIT = LOW_RES_WIDTH / (2.0f * ORTHO_HALF_WIDTH);
+
+constexpr float CAMERA_PAN_SPEED = 4.0f,
+CAMERA_ZOOM_STEP = 1.25f,
+CAMERA_FOLLOW_RATE = 4.0f,
+CAMERA_HIT_SHAKE_MAGNITUDE = 0.08f,
+CAMERA_HIT_SHAKE_DURATION = 0.2f;
+
+constexpr int MAX_MATCHES = 64;
+
+// Per arena, enough for every sprite of MAX_MATCHES matches with room to spare; a frame that needs more
+// still works and grows the arena for the next one
+constexpr size_t FRAME_ARENA_BYTES = 256 * 1024;
+
+// Shared between all matches so the total stays bounded however many are running
+constexpr int MAX_PARTICLES = 100000;
+
+constexpr float PARTICLE_DRAG = 2.5f,
+PARTICLE_SIZE = 0.06f,
+HIT_PARTICLE_SPEED = 4.0f,
+HIT_PARTICLE_SPREAD = 2.0f,
+HIT_PARTICLE_LIFETIME = 0.5f,
+WALL_PARTICLE_SPEED = 2.5f,
+WALL_PARTICLE_SPREAD = 2.5f,
+WALL_PARTICLE_LIFETIME = 0.35f,
+TRAIL_PARTICLE_LIFETIME = 0.3f;
+
+constexpr int MAX_PREDICTED_PATH_POINTS = 16;
+
+constexpr glm::vec4 DEBUG_PADDLE_COLOUR = glm::vec4(0.2f, 1.0f, 0.2f, 1.0f),
+DEBUG_BALL_COLOUR = glm::vec4(1.0f, 0.2f, 0.2f, 1.0f),
+DEBUG_WALL_COLOUR = glm::vec4(0.2f, 0.6f, 1.0f, 1.0f),
+DEBUG_PATH_COLOUR = glm::vec4(1.0f, 1.0f, 0.2f, 1.0f);
+
+constexpr int HIT_PARTICLE_COUNT = 160,
+WALL_PARTICLE_COUNT = 60,
+TRAIL_PARTICLE_COUNT = 3;
+
+constexpr glm::vec4 HIT_PARTICLE_COLOUR = glm::vec4(1.0f, 0.85f, 0.3f, 1.0f),
+WALL_PARTICLE_COLOUR = glm::vec4(1.0f, 1.0f, 1.0f, 0.8f),
+TRAIL_PARTICLE_COLOUR = glm::vec4(0.9f, 1.0f, 0.4f, 0.5f);
+
+constexpr int PLAYER_LAYER = 0,
+EFFECT_LAYER = -1;  // under the players
+
+// A copy of the ball left where it hits something, swelling briefly before it disappears
+constexpr int MAX_IMPACT_POPS = 256;
+constexpr float IMPACT_POP_DURATION = 0.12f,
+IMPACT_POP_GROWTH = 0.8f;  // extra scale reached by the end
 
 SDL_Window* g_display_window = nullptr;
 AppStatus g_app_status = RUNNING;
+bool g_is_pixel_mode = false;
 
 ShaderProgram g_shader_program = ShaderProgram();
+ShaderProgram g_particle_program = ShaderProgram();
+ShaderProgram g_debug_program = ShaderProgram();
 
-GLuint g_background_texture_id,
-g_mario_texture_id,
+GLuint g_mario_texture_id,
 g_luigi_texture_id,
-g_ball_texture_id;
+g_ball_texture_id,
+g_player_1_wins_texture_id,
+g_player_2_wins_texture_id;
 
-glm::mat4 g_view_matrix,
-g_ball_matrix,
-g_paddle_matrix,
-g_right_paddle_matrix,
-g_background_matrix,
-g_projection_matrix;
+glm::mat4 g_projection_matrix;
 
-int right_paddle_swtich = -1;
+TileMap g_court;
+std::string g_court_filepath;  // kept so F6 can read the court again after it is edited
 
+// One entry per match; all three vectors are sized once in initialise() and never reallocate
+std::vector<Match> g_matches;
+std::vector<Camera> g_cameras;
+std::vector<glm::ivec4> g_viewports;  // x, y, width, height
+std::vector<ParticleSystem> g_particles;
+std::vector<glm::vec3> g_ball_positions;  // float copy of each ball for the cameras to follow
+
+struct ImpactPop
+{
+    glm::vec3 position;
+    float age;
+    int match_index;
+};
+
+// Short-lived effects for every match share one pool. Each match remembers its newest pop so the next
+// one can replace it; once a pop has expired its handle just stops resolving.
+ObjectPool<ImpactPop> g_impact_pops;
+std::vector<PoolHandle> g_latest_impact_pops;
+
+int g_focused_match = 0;
+InputQueue g_input_queue;
+ControllerSampler g_controller_sampler;
+
+// Recording logs every tick's input; a replay feeds a recorded log back in place of live input
+InputLogWriter g_input_log_writer;
+InputLogReader g_input_log_reader;
+float g_replay_speed = 1.0f;
+float g_replay_backlog_ms = 0.0f;
+uint32_t g_seed = 0;
+
+// Two-player network play drives the only match through a rollback session instead of simulate_tick()
+RollbackSession g_rollback_session;
+Uint32 g_net_stats_ms = 0;
+
+// Spectating: a broadcaster streams the focused match to remote viewers, and a spectator client shows a
+// remote match in place of a local one
+SpectatorBroadcaster g_spectator_broadcaster;
+SpectatorClient g_spectator_client;
+Uint32 g_spectator_stats_ms = 0;
+glm::vec3 g_camera_movement = glm::vec3(0.0f, 0.0f, 0.0f);
+
+// Transient data for one frame; everything in it is released at the end of the frame after next
+DoubleFrameArena g_frame_arenas(FRAME_ARENA_BYTES);
+int g_frame_arena_grow_count = 0;
+
+SpriteBatch g_sprite_batch;
+PostProcessor g_post_processor;
+DebugDraw g_debug_draw;
+bool g_is_debug_draw_on = false;
 
 float g_previous_ticks = 0.0f;
+Uint32 g_simulation_ms = 0;  // end of the last simulated tick
+uint32_t g_tick = 0;         // ticks simulated so far
+SnapshotRing g_snapshots;
 
-glm::vec3 g_paddle_position = glm::vec3(-4.0f, 0.0f, 0.0f);
-glm::vec3 g_paddle_movement = glm::vec3(0.0f, 0.0f, 0.0f);
-glm::vec3 g_right_paddle_position = glm::vec3(4.0f, 0.0f, 0.0f);
-glm::vec3 g_right_paddle_movement = glm::vec3(0.0f, 0.0f, 0.0f);
-glm::vec3 g_ball_position = glm::vec3(0.0f, 0.0f, 0.0f);
-glm::vec3 g_ball_movement = glm::vec3(0.0f, 0.0f, 0.0f);
-
-float g_paddle_speed = 3.0f;  // move 1 unit per second
-float g_ball_speed = 3.0f;
-
-// Constraints
-float paddle_y_distance = 0,
-paddle_right_y_distance = 0,
-paddle_ball_x_distance = 0,
-paddle_ball_y_distance = 0,
-right_paddle_ball_x_distance = 0,
-right_paddle_ball_y_distance = 0;
-
-void initialise();
+// Shared state the game systems touch, one bit each, so the schedulers can tell which systems may run
+// side by side
+enum GameComponent : ComponentMask
+{
+    COMPONENT_INPUT = 1 << 0,  // g_tick_input, g_focused_match and g_camera_movement
+    COMPONENT_MATCHES = 1 << 1,
+    COMPONENT_CONTACTS = 1 << 2,
+    COMPONENT_PARTICLES = 1 << 3,
+    COMPONENT_CAMERAS = 1 << 4,
+    COMPONENT_BALL_POSITIONS = 1 << 5,
+    COMPONENT_SNAPSHOTS = 1 << 6,
+    COMPONENT_SPECTATORS = 1 << 7,
+    COMPONENT_EFFECTS = 1 << 8
+};
+
+// A simulated tick and the per-frame work after the ticks are each a list of systems, registered once
+// in register_systems(). These globals carry what the systems need from the caller.
+std::unique_ptr<ThreadPool> g_system_pool;
+SystemScheduler g_tick_systems;
+SystemScheduler g_frame_systems;
+MatchInput g_tick_input;          // the focused match's input for the tick being simulated
+ContactQueue g_contacts;          // everything the balls touched on that tick, across all matches
+float g_frame_delta_time = 0.0f;
+Uint32 g_frame_ms = 0;
+
+void initialise(int match_count, const char* court_filepath, int input_sample_rate, int thread_count);
+void register_systems();
 void process_input();
 void update();
 void render();
+void end_frame();
 void shutdown();
 
-GLuint load_texture(const char* filepath);
-void draw_object(glm::mat4& object_model_matrix, GLuint& object_texture_id);
+void simulate_tick(const MatchInput& focused_input);
+void replay_tick();
+void seek_replay(int tick_delta);
+void rewind_matches(int tick_count);
+void reload_court();
+int run_headless_replay();
+void emit_match_effects();
+void report_rollback_stats();
+void report_spectator_stats();
+bool is_quiescent();
+
+GLuint load_texture(const char* filepath, int max_width = 0, int max_height = 0);
+std::vector<unsigned char> downsample_image(const unsigned char* image, int width, int height, int target_width, int target_height);
+int sprite_pixels(float world_size);
+void layout_viewports();
+void queue_object(int match_index, const glm::mat4& object_model_matrix, GLuint object_texture_id, int layer);
+void queue_scoreboard(int match_index);
+glm::mat4 sprite_matrix(const glm::vec3& position, const glm::vec3& scale);
+void apply_match_view(int match_index, float resolution_scale);
+void render_particles(int match_index, float resolution_scale);
+void draw_match_debug(int match_index);
+
+
+std::vector<unsigned char> downsample_image(const unsigned char* image, int width, int height, int target_width, int target_height)
+{
+    // Box filter over premultiplied colour, so transparent texels do not bleed dark fringes into edges
+    std::vector<unsigned char> result(target_width * target_height * 4);
 
+    for (int y = 0; y < target_height; y++)
+    {
+        int source_top = y * height / target_height,
+            source_bottom = std::max((y + 1) * height / target_height, source_top + 1);
 
-GLuint load_texture(const char* filepath)
+        for (int x = 0; x < target_width; x++)
+        {
+            int source_left = x * width / target_width,
+                source_right = std::max((x + 1) * width / target_width, source_left + 1);
+
+            float red = 0.0f, green = 0.0f, blue = 0.0f, alpha = 0.0f;
+            for (int sy = source_top; sy < source_bottom; sy++)
+            {
+                for (int sx = source_left; sx < source_right; sx++)
+                {
+                    const unsigned char* texel = image + (sy * width + sx) * 4;
+                    float texel_alpha = texel[3] / 255.0f;
+                    red += texel[0] * texel_alpha;
+                    green += texel[1] * texel_alpha;
+                    blue += texel[2] * texel_alpha;
+                    alpha += texel_alpha;
+                }
+            }
+
+            unsigned char* out = &result[(y * target_width + x) * 4];
+            int texel_count = (source_bottom - source_top) * (source_right - source_left);
+            out[0] = alpha > 0.0f ? (unsigned char) (red / alpha) : 0;
+            out[1] = alpha > 0.0f ? (unsigned char) (green / alpha) : 0;
+            out[2] = alpha > 0.0f ? (unsigned char) (blue / alpha) : 0;
+            out[3] = (unsigned char) (alpha / texel_count * 255.0f);
+        }
+    }
+
+    return result;
+}
+
+
+int sprite_pixels(float world_size)
+{
+    return std::max(1, (int) std::ceil(world_size * LOW_RES_PIXELS_PER_UNIT));
+}
+
+
+GLuint load_texture(const char* filepath, int max_width, int max_height)
 {
     // STEP 1: Loading the image file
     int width, height, number_of_components;
@@ -118,12 +352,21 @@ GLuint load_texture(const char* filepath)
         assert(false);
     }
 
+    // Optional: shrink oversized art to the size it will actually be drawn at
+    std::vector<unsigned char> downsampled;
+    if (max_width > 0 && max_height > 0 && (width > max_width || height > max_height))
+    {
+        downsampled = downsample_image(image, width, height, std::min(width, max_width), std::min(height, max_height));
+        width = std::min(width, max_width);
+        height = std::min(height, max_height);
+    }
+
     // STEP 2: Generating and binding a texture ID to our image
     GLuint textureID;
     glGenTextures(NUMBER_OF_TEXTURES, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
     glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER,
-        GL_RGBA, GL_UNSIGNED_BYTE, image);
+        GL_RGBA, GL_UNSIGNED_BYTE, downsampled.empty() ? image : downsampled.data());
 
     // STEP 3: Setting our texture filter parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -136,9 +379,39 @@ GLuint load_texture(const char* filepath)
 }
 
 
-void initialise()
+void layout_viewports()
+{
+    // Near-square grid of cells, each holding the largest viewport with the projection's aspect ratio
+    int match_count = (int) g_matches.size();
+    int columns = (int) std::ceil(std::sqrt((float) match_count));
+    int rows = (match_count + columns - 1) / columns;
+
+    int cell_width = WINDOW_WIDTH / columns,
+        cell_height = WINDOW_HEIGHT / rows;
+
+    float aspect_ratio = ORTHO_HALF_WIDTH / ORTHO_HALF_HEIGHT;
+    int viewport_width = std::min(cell_width, (int) (cell_height * aspect_ratio)),
+        viewport_height = (int) (viewport_width / aspect_ratio);
+
+    g_viewports.clear();
+    for (int i = 0; i < match_count; i++)
+    {
+        int column = i % columns,
+            row = i / columns;
+
+        // GL viewports grow upwards, so the first row sits at the top of the window
+        g_viewports.push_back(glm::ivec4(
+            column * cell_width + (cell_width - viewport_width) / 2,
+            WINDOW_HEIGHT - (row + 1) * cell_height + (cell_height - viewport_height) / 2,
+            viewport_width,
+            viewport_height));
+    }
+}
+
+
+void initialise(int match_count, const char* court_filepath, int input_sample_rate, int thread_count)
 {
-    SDL_Init(SDL_INIT_VIDEO);
+    SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER);
     g_display_window = SDL_CreateWindow("Lets play Tennis!",
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         WINDOW_WIDTH, WINDOW_HEIGHT,
@@ -156,34 +429,83 @@ void initialise()
     glewInit();
 #endif
 
-    glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    g_matches.assign(match_count, Match());
+    g_cameras.assign(match_count, Camera(ORTHO_HALF_WIDTH, ORTHO_HALF_HEIGHT));
+    g_ball_positions.assign(match_count, glm::vec3(0.0f));
+    g_particles.assign(match_count, ParticleSystem(MAX_PARTICLES / match_count, PARTICLE_DRAG));
+    for (int i = 0; i < match_count; i++) g_particles[i].seed(g_seed + i);
+    g_impact_pops.reset(MAX_IMPACT_POPS);
+    g_latest_impact_pops.assign(match_count, PoolHandle());
+    layout_viewports();
+
+    g_snapshots.initialise(SNAPSHOT_HISTORY_TICKS, match_count);
+    g_snapshots.save(g_tick, g_matches.data());
+
+    g_contacts.reset(match_count * MAX_CONTACTS_PER_STEP);
+    g_system_pool.reset(new ThreadPool(thread_count));
+    g_tick_systems.set_pool(g_system_pool.get());
+    g_frame_systems.set_pool(g_system_pool.get());
+    register_systems();
 
     g_shader_program.load(V_SHADER_PATH, F_SHADER_PATH);
+    g_particle_program.load(V_PARTICLE_SHADER_PATH, F_PARTICLE_SHADER_PATH);
+    for (ParticleSystem& particles : g_particles) particles.set_program(g_particle_program);
+#ifdef DEBUG_DRAW_ENABLED
+    g_debug_program.load(V_DEBUG_SHADER_PATH, F_DEBUG_SHADER_PATH);
+#endif
 
-    g_ball_texture_id = load_texture(BALL_SPRITE_FILEPATH);
-    g_background_texture_id = load_texture(COURT_SPRITE_FILEPATH);
-    g_mario_texture_id = load_texture(MARIO_SPRITE_FILEPATH);
-    g_luigi_texture_id = load_texture(LUIGI_SPRITE_FILEPATH);
-    g_paddle_matrix = glm::mat4(1.0f);
-    g_right_paddle_matrix = glm::mat4(1.0f);
-    g_background_matrix = glm::mat4(1.0f);
-    g_ball_matrix = glm::mat4(1.0f);
-    g_view_matrix = glm::mat4(1.0f);
-    g_projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
+    // Textures are shared by every match
+    if (g_is_pixel_mode)
+    {
+        // Pre-shrunk to their on-screen size in the low-resolution target, so nothing shimmers
+        g_ball_texture_id = load_texture(BALL_SPRITE_FILEPATH, sprite_pixels(INIT_BALL_SCALE.x), sprite_pixels(INIT_BALL_SCALE.y));
+        g_mario_texture_id = load_texture(MARIO_SPRITE_FILEPATH, sprite_pixels(INIT_PLAYER_1_SCALE.x), sprite_pixels(INIT_PLAYER_1_SCALE.y));
+        g_luigi_texture_id = load_texture(LUIGI_SPRITE_FILEPATH, sprite_pixels(INIT_PLAYER_2_SCALE.x), sprite_pixels(INIT_PLAYER_2_SCALE.y));
+        g_player_1_wins_texture_id = load_texture(PLAYER_1_WINS_FILEPATH, sprite_pixels(WIN_BANNER_SCALE.x), sprite_pixels(WIN_BANNER_SCALE.y));
+        g_player_2_wins_texture_id = load_texture(PLAYER_2_WINS_FILEPATH, sprite_pixels(WIN_BANNER_SCALE.x), sprite_pixels(WIN_BANNER_SCALE.y));
+    }
+    else
+    {
+        g_ball_texture_id = load_texture(BALL_SPRITE_FILEPATH);
+        g_mario_texture_id = load_texture(MARIO_SPRITE_FILEPATH);
+        g_luigi_texture_id = load_texture(LUIGI_SPRITE_FILEPATH);
+        g_player_1_wins_texture_id = load_texture(PLAYER_1_WINS_FILEPATH);
+        g_player_2_wins_texture_id = load_texture(PLAYER_2_WINS_FILEPATH);
+    }
+
+    g_court_filepath = court_filepath;
+    if (!g_court.load(court_filepath))
+    {
+        LOG("Unable to load court. Make sure the path is correct.");
+        assert(false);
+    }
+    g_court.set_tileset_texture(load_texture(g_court.get_tileset_filepath().c_str()));
+    g_projection_matrix = glm::ortho(-ORTHO_HALF_WIDTH, ORTHO_HALF_WIDTH, -ORTHO_HALF_HEIGHT, ORTHO_HALF_HEIGHT, -1.0f, 1.0f);
 
     g_shader_program.set_projection_matrix(g_projection_matrix);
-    g_shader_program.set_view_matrix(g_view_matrix);
+    g_particle_program.set_projection_matrix(g_projection_matrix);
+#ifdef DEBUG_DRAW_ENABLED
+    g_debug_program.set_projection_matrix(g_projection_matrix);
+#endif
 
     glUseProgram(g_shader_program.get_program_id());
     glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    g_post_processor.initialise(WINDOW_WIDTH, WINDOW_HEIGHT,
+        g_is_pixel_mode ? LOW_RES_WIDTH : WINDOW_WIDTH,
+        g_is_pixel_mode ? LOW_RES_HEIGHT : WINDOW_HEIGHT);
+
+    g_controller_sampler.start(input_sample_rate);
 }
 
 
 void process_input()
 {   
+    Camera& camera = g_cameras[g_focused_match];
+
     SDL_Event event;
     while (SDL_PollEvent(&event))
     {
@@ -191,201 +513,951 @@ void process_input()
         {
             g_app_status = TERMINATED;
         }
+        if (event.type == SDL_CONTROLLERDEVICEADDED)
+        {
+            // Includes the controllers already plugged in at startup
+            g_controller_sampler.add_controller(event.cdevice.which);
+        }
+        if (event.type == SDL_CONTROLLERDEVICEREMOVED)
+        {
+            g_controller_sampler.remove_controller(event.cdevice.which);
+        }
+        if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+        {
+            // Paddle, AI and serve keys wait here, timestamped, until the tick they belong to
+            if (!g_input_queue.push(event.key)) LOG("Input queue full; dropping key event.");
+        }
         if (event.type == SDL_KEYDOWN) {
             switch (event.key.keysym.sym) {
-            case SDLK_t:
-                right_paddle_swtich *= -1;
+            case SDLK_f:
+                if (camera.is_following()) camera.stop_following();
+                else camera.follow(&g_ball_positions[g_focused_match], CAMERA_FOLLOW_RATE);
+                break;
+            case SDLK_c:
+                camera.reset();
+                break;
+            case SDLK_r:
+                rewind_matches(REWIND_TICKS);
+                break;
+            case SDLK_COMMA:
+                seek_replay(-REPLAY_SEEK_TICKS);
+                break;
+            case SDLK_PERIOD:
+                seek_replay(REPLAY_SEEK_TICKS);
+                break;
+            case SDLK_EQUALS:
+                camera.zoom_by(CAMERA_ZOOM_STEP);
+                break;
+            case SDLK_MINUS:
+                camera.zoom_by(1.0f / CAMERA_ZOOM_STEP);
+                break;
+            case SDLK_F1:
+                g_post_processor.toggle_effect(POST_BLOOM);
+                break;
+            case SDLK_F2:
+                g_post_processor.toggle_effect(POST_VIGNETTE);
+                break;
+            case SDLK_F3:
+                g_post_processor.toggle_effect(POST_SCANLINES);
+                break;
+            case SDLK_F4:
+                g_post_processor.toggle_profiling();
+                break;
+            case SDLK_F6:
+                reload_court();
                 break;
-            case SDLK_p:
-                g_ball_movement.x = -1;
+#ifdef DEBUG_DRAW_ENABLED
+            case SDLK_F5:
+                g_is_debug_draw_on = !g_is_debug_draw_on;
+                break;
+#endif
+            default:
+                // Number keys hand the keyboard to another match in the grid
+                if (event.key.keysym.sym >= SDLK_1 && event.key.keysym.sym < SDLK_1 + std::min((int) g_matches.size(), 9))
+                {
+                    g_focused_match = event.key.keysym.sym - SDLK_1;
+                }
                 break;
             }
         }
     }
     const Uint8* key_state = SDL_GetKeyboardState(NULL); // if non-NULL, receives the length of the returned array
 
-    g_paddle_movement = glm::vec3(0.0f);
-    g_right_paddle_movement = glm::vec3(0.0f);
+    g_camera_movement = glm::vec3(0.0f);
+
+    // Camera panning on IJKL so it does not clash with either paddle
+    if (key_state[SDL_SCANCODE_I]) g_camera_movement.y += 1;
+    if (key_state[SDL_SCANCODE_K]) g_camera_movement.y -= 1;
+    if (key_state[SDL_SCANCODE_J]) g_camera_movement.x -= 1;
+    if (key_state[SDL_SCANCODE_L]) g_camera_movement.x += 1;
+}
+
+
+void update()
+{
+    /* DELTA TIME */
+    float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND;
+    float delta_time = ticks - g_previous_ticks;
+    g_previous_ticks = ticks;
+
+    /* GAME LOGIC */
+    Uint32 now = SDL_GetTicks();
+    if (g_spectator_client.is_active())
+    {
+        // Nothing is simulated here: the only match just mirrors the newest state from the stream
+        g_spectator_client.poll();
+        if (g_spectator_client.has_frame()) apply_spectator_frame(g_spectator_client.get_latest_frame(), g_matches[0]);
 
-    if (key_state[SDL_SCANCODE_W])
+        g_simulation_ms = now;
+        MatchInput discarded_input = g_input_queue.consume_until(now);
+        g_controller_sampler.consume_until(now, discarded_input);
+    }
+    else if (g_input_log_reader.is_playing())
     {
-        g_paddle_movement.y = 1;
-        if (paddle_y_distance <= 0) {
-            g_paddle_movement.y = 0;
+        // A replay runs the same ticks on its own clock, scaled by the replay speed. Live input is
+        // still drained so it does not pile up, but goes nowhere.
+        g_replay_backlog_ms += delta_time * MILLISECONDS_IN_SECOND * g_replay_speed;
+        int max_ticks = std::max(MAX_TICKS_PER_FRAME, (int) (MAX_TICKS_PER_FRAME * g_replay_speed));
+        for (int tick = 0; tick < max_ticks && g_replay_backlog_ms >= FIXED_TIMESTEP_MS; tick++)
+        {
+            g_replay_backlog_ms -= FIXED_TIMESTEP_MS;
+            replay_tick();
         }
-    }
+        g_replay_backlog_ms = std::min(g_replay_backlog_ms, (float) FIXED_TIMESTEP_MS);
 
-    if (key_state[SDL_SCANCODE_S])
+        g_simulation_ms = now;
+        MatchInput discarded_input = g_input_queue.consume_until(now);
+        g_controller_sampler.consume_until(now, discarded_input);
+    }
+    else
     {
-        g_paddle_movement.y = -1;
-        if (paddle_y_distance >= 6.3) {
-            g_paddle_movement.y = 0;
+        // Each tick consumes only the key events stamped before it ends
+        for (int tick = 0; tick < MAX_TICKS_PER_FRAME && now - g_simulation_ms >= FIXED_TIMESTEP_MS; tick++)
+        {
+            g_simulation_ms += FIXED_TIMESTEP_MS;
+            MatchInput input = g_input_queue.consume_until(g_simulation_ms);
+            g_controller_sampler.consume_until(g_simulation_ms, input);
+
+            if (g_rollback_session.is_active())
+            {
+                uint32_t previous_tick = g_rollback_session.get_tick();
+                g_contacts.clear();
+                g_rollback_session.advance(g_matches[0], input, FIXED_TIMESTEP_MS / MILLISECONDS_IN_SECOND, &g_contacts);
+                emit_match_effects();
+
+                // Spectators see the predicted state; a stalled frame has nothing new to show
+                if (g_rollback_session.get_tick() != previous_tick && g_spectator_broadcaster.is_open())
+                {
+                    g_spectator_broadcaster.record(g_rollback_session.get_tick(), g_matches[0]);
+                }
+                continue;
+            }
+
+            g_input_log_writer.record(input, g_focused_match, g_matches.data());
+            simulate_tick(input);
+        }
+        if (now - g_simulation_ms >= FIXED_TIMESTEP_MS) g_simulation_ms = now;
+
+        if (g_rollback_session.is_active() && now - g_net_stats_ms >= NET_STATS_INTERVAL_MS)
+        {
+            report_rollback_stats();
+            g_net_stats_ms = now;
         }
     }
 
-    if (key_state[SDL_SCANCODE_UP])
+    /* EFFECTS, CAMERA AND STREAMING */
+    g_frame_delta_time = delta_time;
+    g_frame_ms = now;
+    g_frame_systems.run();
+}
+
+
+void register_systems()
+{
+    // Within a tick the matches step first; their effects, snapshot and broadcast only read the result
+    g_tick_systems.add_system("step matches", COMPONENT_INPUT, COMPONENT_MATCHES | COMPONENT_CONTACTS, []
     {
-        g_right_paddle_movement.y = 1;
-        if (paddle_right_y_distance <= 0.0) {
-            g_right_paddle_movement.y = 0;
+        // Only the focused match listens to the keyboard; the rest run on their own inputs
+        const MatchInput idle_input;
+        g_contacts.clear();
+        for (size_t i = 0; i < g_matches.size(); i++)
+        {
+            update_match(g_matches[i], (int) i == g_focused_match ? g_tick_input : idle_input,
+                FIXED_TIMESTEP_MS / MILLISECONDS_IN_SECOND, &g_contacts, (int) i);
         }
-    }
+    });
+    g_tick_systems.add_system("match effects", COMPONENT_MATCHES | COMPONENT_CONTACTS, COMPONENT_PARTICLES | COMPONENT_CAMERAS | COMPONENT_EFFECTS, []
+    {
+        emit_match_effects();
+    });
+    g_tick_systems.add_system("snapshots", COMPONENT_MATCHES, COMPONENT_SNAPSHOTS, []
+    {
+        g_snapshots.save(g_tick, g_matches.data());
+    });
+    g_tick_systems.add_system("spectator record", COMPONENT_MATCHES | COMPONENT_INPUT, COMPONENT_SPECTATORS, []
+    {
+        if (g_spectator_broadcaster.is_open()) g_spectator_broadcaster.record(g_tick, g_matches[g_focused_match]);
+    });
+    g_tick_systems.build();
 
-    if (key_state[SDL_SCANCODE_DOWN])
+    // Once a frame, after however many ticks it ran
+    g_frame_systems.add_system("spectator stream", 0, COMPONENT_SPECTATORS, []
     {
-        g_right_paddle_movement.y = -1;
-        if (paddle_right_y_distance >= 6.3) {
-            g_right_paddle_movement.y = 0;
+        if (!g_spectator_broadcaster.is_open()) return;
+
+        g_spectator_broadcaster.poll();
+        if (g_frame_ms - g_spectator_stats_ms >= NET_STATS_INTERVAL_MS)
+        {
+            report_spectator_stats();
+            g_spectator_stats_ms = g_frame_ms;
+        }
+    });
+    g_frame_systems.add_system("particles", 0, COMPONENT_PARTICLES, []
+    {
+        for (ParticleSystem& particles : g_particles) particles.update(g_frame_delta_time);
+    });
+    g_frame_systems.add_system("impact pops", 0, COMPONENT_EFFECTS, []
+    {
+        // From the back, since destroying moves the last pop into the freed place
+        for (int i = g_impact_pops.get_count() - 1; i >= 0; i--)
+        {
+            g_impact_pops[i].age += g_frame_delta_time;
+            if (g_impact_pops[i].age >= IMPACT_POP_DURATION) g_impact_pops.destroy_at(i);
         }
+    });
+    g_frame_systems.add_system("ball positions", COMPONENT_MATCHES, COMPONENT_BALL_POSITIONS, []
+    {
+        for (size_t i = 0; i < g_matches.size(); i++) g_ball_positions[i] = to_vec3(g_matches[i].ball_position);
+    });
+    g_frame_systems.add_system("cameras", COMPONENT_INPUT | COMPONENT_BALL_POSITIONS, COMPONENT_CAMERAS, []
+    {
+        if (g_camera_movement != glm::vec3(0.0f))
+        {
+            Camera& camera = g_cameras[g_focused_match];
+            camera.pan(g_camera_movement * CAMERA_PAN_SPEED / camera.get_zoom() * g_frame_delta_time);
+        }
+        for (Camera& camera : g_cameras) camera.update(g_frame_delta_time);
+    });
+    g_frame_systems.build();
+}
+
+
+void simulate_tick(const MatchInput& focused_input)
+{
+    // Finished matches wait for a serve to start over, so nothing here ever ends the program.
+    // g_tick already counts this tick while the systems run; the snapshot and broadcast are stamped with it.
+    g_tick_input = focused_input;
+    g_tick++;
+    g_tick_systems.run();
+}
+
+
+void rewind_matches(int tick_count)
+{
+    // Recordings, replays and the network peer only know forward input, so a rewind would break them
+    if (g_input_log_writer.is_open() || g_input_log_reader.is_playing() || g_rollback_session.is_active())
+    {
+        LOG("Rewind is unavailable while recording, replaying or playing online.");
+        return;
     }
 
-    /* Etc... */
+    // Go back as far as the history allows
+    uint32_t target = g_tick > (uint32_t) tick_count ? g_tick - tick_count : 0;
+    while (target < g_tick && !g_snapshots.has(target)) target++;
+
+    g_snapshots.restore(target, g_matches.data());
+    g_tick = target;
+    for (ParticleSystem& particles : g_particles) particles.clear();
+    g_impact_pops.clear();
 }
 
 
-void update()
+void replay_tick()
 {
-    /* DELTA TIME */
-    float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND;
-    float delta_time = ticks - g_previous_ticks;
-    g_previous_ticks = ticks;
+    MatchInput input;
+    int focused_match;
+    if (!g_input_log_reader.next(input, focused_match))
+    {
+        LOG("Replay finished; back to live input.");
+        return;
+    }
 
-    /* GAME LOGIC */
-    g_ball_position += g_ball_movement * g_ball_speed * delta_time;
-    g_paddle_position += g_paddle_movement * g_paddle_speed * delta_time;
-    if (right_paddle_swtich == -1) {
-        g_right_paddle_position += g_right_paddle_movement * g_paddle_speed * delta_time;
+    g_focused_match = std::min(focused_match, (int) g_matches.size() - 1);
+    simulate_tick(input);
+}
+
+
+void reload_court()
+{
+    std::string tileset_filepath = g_court.get_tileset_filepath();
+    if (!g_court.reload(g_court_filepath.c_str()))
+    {
+        LOG("Unable to reload court; keeping the one on screen.");
+        return;
     }
-    else{
-        if (g_ball_position.y < g_right_paddle_position.y) {
-            g_right_paddle_position += glm::vec3(0.0f, -1.0f, 0.0f) * g_paddle_speed * delta_time;
-        }
-        else if (g_ball_position.y > g_right_paddle_position.y) {
-            g_right_paddle_position += glm::vec3(0.0f, 1.0f, 0.0f) * g_paddle_speed * delta_time;
-        }
+
+    // Edited tiles only rebuild their own chunks, on the next draw
+    if (g_court.get_tileset_filepath() != tileset_filepath)
+    {
+        GLuint old_texture_id = g_court.get_tileset_texture();
+        glDeleteTextures(NUMBER_OF_TEXTURES, &old_texture_id);
+        g_court.set_tileset_texture(load_texture(g_court.get_tileset_filepath().c_str()));
     }
+    LOG("Reloaded court from " << g_court_filepath);
+}
+
 
-    /* DISTANCE CALCULATIONS*/
-    paddle_y_distance = 3.15 - g_paddle_position.y;
-    paddle_right_y_distance = 3.15 - g_right_paddle_position.y;
-    paddle_ball_x_distance = fabs(g_ball_position.x - g_paddle_position.x) - (INIT_BALL_SCALE.x + INIT_PLAYER_1_SCALE.x) / 2;
-    paddle_ball_y_distance = fabs(g_ball_position.y - g_paddle_position.y) - (INIT_BALL_SCALE.y + INIT_PLAYER_1_SCALE.y) / 2;
-    right_paddle_ball_x_distance = fabs(g_ball_position.x - g_right_paddle_position.x) - (INIT_BALL_SCALE.x + INIT_PLAYER_2_SCALE.x) / 2;
-    right_paddle_ball_y_distance = fabs(g_ball_position.y - g_right_paddle_position.y) - (INIT_BALL_SCALE.y + INIT_PLAYER_2_SCALE.y) / 2;
-    
-    if (paddle_ball_x_distance <= 0 && paddle_ball_y_distance <= 0)
+void seek_replay(int tick_delta)
+{
+    // Seeking backwards from the end picks a finished replay back up
+    if (!g_input_log_reader.can_seek()) return;
+
+    uint32_t target = (uint32_t) std::max((int) g_input_log_reader.get_tick() + tick_delta, 0);
+    if (!g_input_log_reader.seek(target, g_matches.data())) return;
+
+    // The snapshots and effects belong to the timeline being left
+    g_tick = g_input_log_reader.get_tick();
+    g_snapshots.clear();
+    g_snapshots.save(g_tick, g_matches.data());
+    g_replay_backlog_ms = 0.0f;
+    for (ParticleSystem& particles : g_particles) particles.clear();
+    g_impact_pops.clear();
+}
+
+
+int run_headless_replay()
+{
+    // Just the simulation: no window, no GL, no effects, and as fast as the CPU allows
+    const InputLogHeader& header = g_input_log_reader.get_header();
+    g_matches.assign(header.match_count, Match());
+    if (g_input_log_reader.can_seek()) g_input_log_reader.seek(0, g_matches.data());
+
+    const MatchInput idle_input;
+    const float delta_time = header.tick_ms / MILLISECONDS_IN_SECOND;
+    MatchInput input;
+    int focused_match = 0;
+    long tick_count = 0;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    while (g_input_log_reader.next(input, focused_match))
     {
-        g_ball_movement.x = 1;
-        g_ball_speed *= 1.015;
-        if (g_paddle_movement.y < 0)
+        for (size_t i = 0; i < g_matches.size(); i++)
         {
-            g_ball_movement.y = -1;
+            update_match(g_matches[i], (int) i == focused_match ? input : idle_input, delta_time);
         }
-        else if (g_paddle_movement.y > 0)
+        tick_count++;
+    }
+    double seconds = (double) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    LOG("Replayed " << tick_count << " ticks in " << seconds * 1000.0 << " ms ("
+        << (seconds > 0.0 ? tick_count / seconds : 0.0) << " ticks/s)");
+
+    if (g_input_log_reader.can_seek() && tick_count > 0)
+    {
+        // Seek cost is bounded by the keyframe interval, not by the distance travelled
+        constexpr int SEEK_SAMPLES = 100;
+        std::vector<Match> scratch(header.match_count);
+        start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < SEEK_SAMPLES; i++)
         {
-            g_ball_movement.y = 1;
+            g_input_log_reader.seek((uint32_t) ((SEEK_SAMPLES - i) * 7919L % tick_count), scratch.data());
         }
+        double seek_seconds = (double) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+        LOG("Random seeks average " << seek_seconds * 1000000.0 / SEEK_SAMPLES << " us");
+    }
+    for (size_t i = 0; i < g_matches.size(); i++)
+    {
+        LOG("Match " << i + 1 << ": " << g_matches[i].left_score << " - " << g_matches[i].right_score
+            << ", state " << std::hex << hash_match(g_matches[i]) << std::dec);
     }
-    else if (right_paddle_ball_x_distance <= 0 && right_paddle_ball_y_distance <= 0)
+    return 0;
+}
+
+
+void report_rollback_stats()
+{
+    RollbackSession::Stats stats = g_rollback_session.take_stats();
+    int frames = std::max(stats.frames, 1);
+
+    LOG("Rollback: " << stats.rollbacks << " rollbacks, " << (float) stats.resimulated_ticks / frames
+        << " resimulated ticks/frame, " << stats.resimulation_us / frames << " us/frame average, "
+        << stats.max_frame_resimulation_us << " us worst frame, " << stats.stalled_ticks << " stalls");
+}
+
+
+void report_spectator_stats()
+{
+    SpectatorBroadcaster::Stats stats = g_spectator_broadcaster.take_stats();
+    if (stats.subscribers == 0) return;
+
+    LOG("Spectators: " << stats.subscribers << " watching, " << stats.batches << " batches, " << stats.encodings
+        << " encodings, " << stats.packets_sent << " packets, " << stats.bytes_sent << " bytes");
+}
+
+
+void emit_match_effects()
+{
+    // One pass over the tick's contacts, which arrive match by match in the order they were resolved
+    for (const Contact& contact : g_contacts)
     {
-        g_ball_movement.x = -1;
-        g_ball_speed *= 1.015;
-        if (g_right_paddle_movement.y < 0)
+        if (contact.type == CONTACT_GOAL) continue;
+
+        int match_index = contact.match_index;
+        const Match& match = g_matches[match_index];
+        ParticleSystem& particles = g_particles[match_index];
+        glm::vec3 ball_position = to_vec3(match.ball_position);
+
+        // Bursts fly back the way the ball is now heading; wall sparks spray off the wall
+        if (contact.type == CONTACT_WALL)
         {
-            g_ball_movement.y = -1;
+            glm::vec3 away_from_wall = glm::vec3(0.0f, (float) contact.normal_y, 0.0f);
+            particles.emit(ball_position, away_from_wall * WALL_PARTICLE_SPEED, WALL_PARTICLE_SPREAD,
+                WALL_PARTICLE_COUNT, WALL_PARTICLE_COLOUR, WALL_PARTICLE_LIFETIME);
         }
-        else if (g_right_paddle_movement.y > 0)
+        else
         {
-            g_ball_movement.y = 1;
+            g_cameras[match_index].shake(CAMERA_HIT_SHAKE_MAGNITUDE, CAMERA_HIT_SHAKE_DURATION);
+            particles.emit(ball_position, to_vec3(match.ball_movement) * HIT_PARTICLE_SPEED, HIT_PARTICLE_SPREAD,
+                HIT_PARTICLE_COUNT, HIT_PARTICLE_COLOUR, HIT_PARTICLE_LIFETIME);
         }
+
+        g_impact_pops.destroy(g_latest_impact_pops[match_index]);
+        g_latest_impact_pops[match_index] = g_impact_pops.spawn({ ball_position, 0.0f, match_index });
     }
-    if ((g_ball_position.y >= 3.5) || (g_ball_position.y <= -3.5))
+
+    for (size_t i = 0; i < g_matches.size(); i++)
     {
-        g_ball_movement.y *= -1;
+        if (g_matches[i].phase != PHASE_RALLY) continue;
+        g_particles[i].emit(to_vec3(g_matches[i].ball_position), glm::vec3(0.0f), 0.0f,
+            TRAIL_PARTICLE_COUNT, TRAIL_PARTICLE_COLOUR, TRAIL_PARTICLE_LIFETIME);
     }
+}
 
-    /* TRANSFORMATIONS */
-    g_paddle_matrix = glm::mat4(1.0f);
-    g_right_paddle_matrix = glm::mat4(1.0f);
-    g_background_matrix = glm::mat4(1.0f);
-    g_ball_matrix = glm::mat4(1.0f);
 
-    g_background_matrix = glm::scale(g_background_matrix, INIT_SCALE);
+bool is_quiescent()
+{
+    if (g_input_log_reader.is_playing() || g_rollback_session.is_active()) return false;
+    if (g_spectator_broadcaster.is_open() || g_spectator_client.is_active()) return false;
 
-    g_ball_matrix = glm::translate(g_ball_matrix, g_ball_position);
-    g_ball_matrix = glm::scale(g_ball_matrix, INIT_BALL_SCALE);
+    // Held or still-queued keys keep the loop awake even when they have nothing left to move
+    if (g_input_queue.is_any_key_held() || !g_input_queue.is_empty()) return false;
+    if (g_controller_sampler.is_any_stick_held()) return false;
+    if (g_camera_movement != glm::vec3(0.0f)) return false;
 
-    g_paddle_matrix = glm::translate(g_paddle_matrix, g_paddle_position);
-    g_paddle_matrix = glm::scale(g_paddle_matrix, INIT_PLAYER_1_SCALE);
+    for (size_t i = 0; i < g_matches.size(); i++)
+    {
+        const Match& match = g_matches[i];
 
+        // A scored point counts down to the next serve by itself
+        if (match.phase == PHASE_RALLY || match.phase == PHASE_POINT_SCORED) return false;
 
-    g_right_paddle_matrix = glm::translate(g_right_paddle_matrix, g_right_paddle_position);
-    g_right_paddle_matrix = glm::scale(g_right_paddle_matrix, INIT_PLAYER_2_SCALE);
+        // Paddles only move while serving or rallying; a finished match cannot move anything
+        bool is_paddle_moving = to_vec3(match.paddle_movement) != glm::vec3(0.0f) || to_vec3(match.right_paddle_movement) != glm::vec3(0.0f);
+        if (match.phase == PHASE_SERVE && is_paddle_moving) return false;
+        if (g_particles[i].get_count() > 0) return false;
+        if (g_cameras[i].is_animating()) return false;
+    }
+
+    return true;
+}
 
-    /* TERMINATION */
-    if (g_ball_position.x >= 5 || g_ball_position.x <= -5)
+
+glm::mat4 sprite_matrix(const glm::vec3& position, const glm::vec3& scale)
+{
+    glm::mat4 model_matrix = glm::translate(glm::mat4(1.0f), position);
+    return glm::scale(model_matrix, scale);
+}
+
+
+void queue_object(int match_index, const glm::mat4& object_model_matrix, GLuint object_texture_id, int layer)
+{
+    // Anything entirely outside the match camera's rectangle never reaches the GPU
+    if (!g_cameras[match_index].is_visible(object_model_matrix)) return;
+
+    g_sprite_batch.add(object_model_matrix, object_texture_id, layer);
+}
+
+
+void queue_scoreboard(int match_index)
+{
+    const Match& match = g_matches[match_index];
+
+    for (int point = 0; point < match.left_score; point++)
+    {
+        glm::vec3 position = glm::vec3(-SCORE_PIP_START_X - point * SCORE_PIP_SPACING, SCORE_PIP_Y, 0.0f);
+        queue_object(match_index, sprite_matrix(position, SCORE_PIP_SCALE), g_ball_texture_id, PLAYER_LAYER);
+    }
+    for (int point = 0; point < match.right_score; point++)
     {
-        g_app_status = TERMINATED;
+        glm::vec3 position = glm::vec3(SCORE_PIP_START_X + point * SCORE_PIP_SPACING, SCORE_PIP_Y, 0.0f);
+        queue_object(match_index, sprite_matrix(position, SCORE_PIP_SCALE), g_ball_texture_id, PLAYER_LAYER);
+    }
+
+    if (match.phase == PHASE_MATCH_OVER)
+    {
+        GLuint banner_texture_id = match.left_score > match.right_score ? g_player_1_wins_texture_id : g_player_2_wins_texture_id;
+        queue_object(match_index, sprite_matrix(glm::vec3(0.0f), WIN_BANNER_SCALE), banner_texture_id, PLAYER_LAYER);
     }
 }
 
 
-void draw_object(glm::mat4& object_model_matrix, GLuint& object_texture_id)
+void apply_match_view(int match_index, float resolution_scale)
 {
-    g_shader_program.set_model_matrix(object_model_matrix);
-    glBindTexture(GL_TEXTURE_2D, object_texture_id);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    const glm::ivec4& viewport = g_viewports[match_index];
+    glViewport((int) (viewport.x * resolution_scale), (int) (viewport.y * resolution_scale),
+        (int) (viewport.z * resolution_scale), (int) (viewport.w * resolution_scale));
+
+    // With several cameras sharing one view uniform, each one must re-upload when its turn comes
+    if (g_matches.size() > 1) g_cameras[match_index].mark_dirty();
+    if (g_cameras[match_index].apply(g_shader_program))
+    {
+        g_particle_program.set_view_matrix(g_cameras[match_index].get_view_matrix());
+#ifdef DEBUG_DRAW_ENABLED
+        g_debug_program.set_view_matrix(g_cameras[match_index].get_view_matrix());
+#endif
+    }
+}
+
+
+void render_particles(int match_index, float resolution_scale)
+{
+    // Additive blending so overlapping sparks glow instead of stacking opaquely
+    float pixels_per_unit = g_viewports[match_index].z * resolution_scale / (2.0f * ORTHO_HALF_WIDTH) * g_cameras[match_index].get_zoom();
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    g_particles[match_index].render(PARTICLE_SIZE * pixels_per_unit);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+
+void draw_match_debug(int match_index)
+{
+#ifdef DEBUG_DRAW_ENABLED
+    const Match& match = g_matches[match_index];
+
+    // Exactly the boxes update_match() tests against
+    g_debug_draw.box(to_vec3(match.paddle_position), INIT_PLAYER_1_SCALE / 2.0f, DEBUG_PADDLE_COLOUR);
+    g_debug_draw.box(to_vec3(match.right_paddle_position), INIT_PLAYER_2_SCALE / 2.0f, DEBUG_PADDLE_COLOUR);
+    g_debug_draw.box(to_vec3(match.ball_position), INIT_BALL_SCALE / 2.0f, DEBUG_BALL_COLOUR);
+    g_debug_draw.circle(to_vec3(match.ball_position), INIT_BALL_SCALE.x, DEBUG_BALL_COLOUR);
+
+    g_debug_draw.line(glm::vec3(-COURT_HALF_WIDTH, WALL_Y, 0.0f), glm::vec3(COURT_HALF_WIDTH, WALL_Y, 0.0f), DEBUG_WALL_COLOUR);
+    g_debug_draw.line(glm::vec3(-COURT_HALF_WIDTH, -WALL_Y, 0.0f), glm::vec3(COURT_HALF_WIDTH, -WALL_Y, 0.0f), DEBUG_WALL_COLOUR);
+
+    glm::vec3 path[MAX_PREDICTED_PATH_POINTS];
+    int path_length = predict_ball_path(match, path, MAX_PREDICTED_PATH_POINTS);
+    g_debug_draw.path(path, path_length, DEBUG_PATH_COLOUR);
+
+    g_debug_draw.flush(g_debug_program);
+#endif
 }
 
 
 void render()
 {
+    int match_count = (int) g_matches.size();
+    bool is_bloom_on = g_post_processor.is_enabled(POST_BLOOM);
+    float scene_scale = g_post_processor.get_scene_scale();
+
+    // Every match is queued into the one shared batch, one range per viewport, followed by one glow
+    // range per viewport holding only what bloom should pick up
+    g_sprite_batch.begin(g_frame_arenas.get_current());
+    for (int i = 0; i < match_count; i++)
+    {
+        const Match& match = g_matches[i];
+
+        g_sprite_batch.begin_range();
+        queue_object(i, sprite_matrix(to_vec3(match.paddle_position), INIT_PLAYER_1_SCALE), g_mario_texture_id, PLAYER_LAYER);
+        queue_object(i, sprite_matrix(to_vec3(match.right_paddle_position), INIT_PLAYER_2_SCALE), g_luigi_texture_id, PLAYER_LAYER);
+        queue_object(i, sprite_matrix(to_vec3(match.ball_position), INIT_BALL_SCALE), g_ball_texture_id, PLAYER_LAYER);
+        queue_scoreboard(i);
+
+        for (const ImpactPop& pop : g_impact_pops)
+        {
+            if (pop.match_index != i) continue;
+            glm::vec3 scale = INIT_BALL_SCALE * (1.0f + IMPACT_POP_GROWTH * pop.age / IMPACT_POP_DURATION);
+            queue_object(i, sprite_matrix(pop.position, scale), g_ball_texture_id, EFFECT_LAYER);
+        }
+    }
+    for (int i = 0; is_bloom_on && i < match_count; i++)
+    {
+        g_sprite_batch.begin_range();
+        queue_object(i, sprite_matrix(to_vec3(g_matches[i].ball_position), INIT_BALL_SCALE), g_ball_texture_id, PLAYER_LAYER);
+    }
+    g_sprite_batch.build();
+
+    g_post_processor.begin_scene();
     glClear(GL_COLOR_BUFFER_BIT);
 
-    float vertices[] = {
-        -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f,  // triangle 1
-        -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f   // triangle 2
-    };
-
-    // Textures
-    float texture_coordinates[] = {
-        0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,     // triangle 1
-        0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f,     // triangle 2
-    };
-
-    glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false,
-        0, vertices);
-    glEnableVertexAttribArray(g_shader_program.get_position_attribute());
-
-    glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT,
-        false, 0, texture_coordinates);
-    glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
-
-    // Bind texture
-    draw_object(g_background_matrix, g_background_texture_id);
-    draw_object(g_paddle_matrix, g_mario_texture_id);
-    draw_object(g_right_paddle_matrix, g_luigi_texture_id);
-    draw_object(g_ball_matrix, g_ball_texture_id);
-    // We disable two attribute arrays now
-    glDisableVertexAttribArray(g_shader_program.get_position_attribute());
-    glDisableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+    for (int i = 0; i < match_count; i++)
+    {
+        apply_match_view(i, scene_scale);
+
+        // The court is shared by every match and drawn from its static chunk buffers
+        g_court.render(g_shader_program, g_cameras[i]);
+        g_sprite_batch.draw_range(g_shader_program, i);
+        render_particles(i, scene_scale);
+
+        if (g_is_debug_draw_on) draw_match_debug(i);
+    }
+
+    if (is_bloom_on)
+    {
+        g_post_processor.begin_glow();
+
+        for (int i = 0; i < match_count; i++)
+        {
+            apply_match_view(i, scene_scale * PostProcessor::GLOW_SCALE);
+            g_sprite_batch.draw_range(g_shader_program, match_count + i);
+            render_particles(i, scene_scale * PostProcessor::GLOW_SCALE);
+        }
+    }
+
+    g_post_processor.finish();
 
     SDL_GL_SwapWindow(g_display_window);
 }
 
 
-void shutdown() { SDL_Quit(); }
+void end_frame()
+{
+    g_frame_arenas.end_frame();
+
+    // Growing means some frame went past the arena and used the general heap; steady frames never do
+    if (g_frame_arenas.get_grow_count() != g_frame_arena_grow_count)
+    {
+        g_frame_arena_grow_count = g_frame_arenas.get_grow_count();
+        LOG("Frame arena grew; most used in one frame is now " << g_frame_arenas.get_high_water_mark() / 1024 << " KB.");
+    }
+}
+
+
+void shutdown()
+{
+    LOG("Frame arena high-water mark: " << g_frame_arenas.get_high_water_mark() / 1024 << " KB of "
+        << FRAME_ARENA_BYTES / 1024 << " KB.");
+    g_controller_sampler.stop();
+    g_input_log_writer.close();
+    g_rollback_session.stop();
+    g_spectator_broadcaster.close();
+    g_spectator_client.close();
+    g_court.destroy();
+    g_post_processor.shutdown();
+    SDL_Quit();
+}
 
 
 int main(int argc, char* argv[])
 {
-    initialise();
+    int match_count = 1;
+    int thread_count = 0;  // for the game systems; 0 uses every hardware thread
+    const char* court_filepath = DEFAULT_COURT_FILEPATH;
+    int input_sample_rate = ControllerSampler::DEFAULT_SAMPLE_RATE;
+    const char* record_filepath = nullptr;
+    const char* replay_filepath = nullptr;
+    bool is_headless = false;
+
+    // Network play: --net-side left|right --net-port P --net-peer HOST:PORT, with optional link conditions
+    // for testing. --net-test TICKS plays two bots against each other over loopback instead.
+    int net_side = -1;
+    uint16_t net_port = 7000;
+    const char* net_peer = nullptr;
+    int net_delay = RollbackSession::DEFAULT_INPUT_DELAY,
+        net_window = RollbackSession::DEFAULT_ROLLBACK_WINDOW,
+        net_latency_ms = 0,
+        net_jitter_ms = 0,
+        net_test_ticks = 0;
+    float net_loss = 0.0f;
+
+    // Dedicated server: --server PORT hosts --server-matches N matches without a window. --swarm HOST:PORT
+    // plays that many matches against a server with bots, for load testing.
+    int server_port = -1,
+        server_match_count = 1000,
+        server_thread_count = 0,
+        server_seconds = 0;
+    const char* swarm_target = nullptr;
+    AiLevel ai_level = AI_NORMAL;
+
+    // Spectating: --broadcast PORT streams the focused match; --spectate HOST:PORT watches one
+    int broadcast_port = -1;
+    const char* spectate_target = nullptr;
+
+    // Balancing runs: --batch N steps N matches on the vectorised batch simulator and reports throughput
+    int batch_match_count = 0,
+        batch_tick_count = 10000,
+        batch_thread_count = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--matches") == 0 && i + 1 < argc)
+        {
+            match_count = std::max(1, std::min(std::atoi(argv[++i]), MAX_MATCHES));
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            thread_count = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--pixel") == 0)
+        {
+            g_is_pixel_mode = true;
+        }
+        else if (std::strcmp(argv[i], "--court") == 0 && i + 1 < argc)
+        {
+            court_filepath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--input-rate") == 0 && i + 1 < argc)
+        {
+            input_sample_rate = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            record_filepath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replay_filepath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc)
+        {
+            g_replay_speed = std::max(0.01f, (float) std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            is_headless = true;
+        }
+        else if (std::strcmp(argv[i], "--net-side") == 0 && i + 1 < argc)
+        {
+            net_side = std::strcmp(argv[++i], "right") == 0 ? 1 : 0;
+        }
+        else if (std::strcmp(argv[i], "--net-port") == 0 && i + 1 < argc)
+        {
+            net_port = (uint16_t) std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--net-peer") == 0 && i + 1 < argc)
+        {
+            net_peer = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--net-delay") == 0 && i + 1 < argc)
+        {
+            net_delay = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--net-window") == 0 && i + 1 < argc)
+        {
+            net_window = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--net-latency") == 0 && i + 1 < argc)
+        {
+            net_latency_ms = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--net-jitter") == 0 && i + 1 < argc)
+        {
+            net_jitter_ms = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--net-loss") == 0 && i + 1 < argc)
+        {
+            net_loss = (float) std::atof(argv[++i]) / 100.0f;  // given in percent
+        }
+        else if (std::strcmp(argv[i], "--net-test") == 0 && i + 1 < argc)
+        {
+            net_test_ticks = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--server") == 0 && i + 1 < argc)
+        {
+            server_port = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--server-matches") == 0 && i + 1 < argc)
+        {
+            server_match_count = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--server-threads") == 0 && i + 1 < argc)
+        {
+            server_thread_count = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--server-seconds") == 0 && i + 1 < argc)
+        {
+            server_seconds = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--swarm") == 0 && i + 1 < argc)
+        {
+            swarm_target = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--ai-level") == 0 && i + 1 < argc)
+        {
+            const char* level = argv[++i];
+            ai_level = std::strcmp(level, "easy") == 0 ? AI_EASY : std::strcmp(level, "hard") == 0 ? AI_HARD : AI_NORMAL;
+        }
+        else if (std::strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc)
+        {
+            broadcast_port = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--spectate") == 0 && i + 1 < argc)
+        {
+            spectate_target = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+        {
+            batch_match_count = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--batch-ticks") == 0 && i + 1 < argc)
+        {
+            batch_tick_count = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--batch-threads") == 0 && i + 1 < argc)
+        {
+            batch_thread_count = std::atoi(argv[++i]);
+        }
+    }
+
+    g_seed = (uint32_t) std::time(nullptr);
+
+    if (batch_match_count > 0)
+    {
+        BatchRunStats stats = run_batch_simulation(batch_match_count, batch_tick_count, batch_thread_count,
+            FIXED_TIMESTEP_MS / MILLISECONDS_IN_SECOND);
+        LOG("Batch: " << stats.match_ticks << " match ticks in " << stats.seconds * 1000.0 << " ms ("
+            << stats.match_ticks / stats.seconds / 1000000.0 << " million/s, " << BatchSimulator::INSTRUCTION_SET << ")");
+        LOG(stats.points << " points, " << (stats.points > 0 ? (float) stats.hits / stats.points : 0.0f) << " hits per point");
+        return 0;
+    }
+    if (server_port >= 0)
+    {
+        MatchServer server;
+        if (!server.start((uint16_t) server_port, server_match_count, server_thread_count, FIXED_TIMESTEP_MS, ai_level)) return 1;
+        server.run(server_seconds);
+        server.stop();
+        return 0;
+    }
+    if (swarm_target != nullptr)
+    {
+        std::string swarm_host = swarm_target;
+        size_t port_separator = swarm_host.rfind(':');
+        if (port_separator == std::string::npos)
+        {
+            LOG("--swarm needs HOST:PORT.");
+            return 1;
+        }
+        uint16_t swarm_port = (uint16_t) std::atoi(swarm_host.c_str() + port_separator + 1);
+        swarm_host = swarm_host.substr(0, port_separator);
+
+        return run_client_swarm(swarm_host.c_str(), swarm_port, server_match_count,
+            server_seconds > 0 ? server_seconds : 10, FIXED_TIMESTEP_MS);
+    }
+    if (net_test_ticks > 0)
+    {
+        return run_rollback_loopback_test(net_test_ticks, FIXED_TIMESTEP_MS, net_latency_ms, net_jitter_ms, net_loss,
+            net_port, net_delay, net_window);
+    }
+    if (net_side >= 0)
+    {
+        if (net_peer == nullptr || replay_filepath != nullptr || record_filepath != nullptr)
+        {
+            LOG("--net-side needs --net-peer HOST:PORT and cannot be combined with --record or --replay.");
+            return 1;
+        }
+        match_count = 1;
+    }
+    if (spectate_target != nullptr)
+    {
+        if (net_side >= 0 || replay_filepath != nullptr || record_filepath != nullptr)
+        {
+            LOG("--spectate cannot be combined with --net-side, --record or --replay.");
+            return 1;
+        }
+        match_count = 1;
+    }
+
+    if (replay_filepath != nullptr)
+    {
+        if (!g_input_log_reader.load(replay_filepath)) return 1;
+
+        const InputLogHeader& header = g_input_log_reader.get_header();
+        if (header.tick_ms != FIXED_TIMESTEP_MS)
+        {
+            LOG("Replay was recorded with " << header.tick_ms << " ms ticks; this build uses " << FIXED_TIMESTEP_MS << " ms.");
+            return 1;
+        }
+        if (header.build_hash != simulation_build_hash())
+        {
+            LOG("Replay was recorded by a different build and may not play out the same.");
+        }
+
+        match_count = std::max(1, std::min((int) header.match_count, MAX_MATCHES));
+        g_seed = header.seed;
+
+        if (is_headless) return run_headless_replay();
+    }
+    else if (is_headless)
+    {
+        LOG("--headless only makes sense with --replay.");
+        return 1;
+    }
+
+    initialise(match_count, court_filepath, input_sample_rate, thread_count);
+
+    // A replay starts from its recorded first keyframe, AI level included, not from the command line
+    if (g_input_log_reader.can_seek()) g_input_log_reader.seek(0, g_matches.data());
+    else for (Match& match : g_matches) match.ai_level = ai_level;
+
+    if (net_side >= 0)
+    {
+        std::string peer_host = net_peer;
+        size_t port_separator = peer_host.rfind(':');
+        uint16_t peer_port = port_separator == std::string::npos ? net_port : (uint16_t) std::atoi(peer_host.c_str() + port_separator + 1);
+        peer_host = peer_host.substr(0, port_separator);
+
+        if (!g_rollback_session.start(net_side, net_port, peer_host.c_str(), peer_port, net_delay, net_window))
+        {
+            shutdown();
+            return 1;
+        }
+        g_rollback_session.set_conditions(net_latency_ms, net_jitter_ms, net_loss);
+    }
+
+    if (spectate_target != nullptr)
+    {
+        std::string spectate_host = spectate_target;
+        size_t port_separator = spectate_host.rfind(':');
+        uint16_t spectate_port = port_separator == std::string::npos ? net_port : (uint16_t) std::atoi(spectate_host.c_str() + port_separator + 1);
+        spectate_host = spectate_host.substr(0, port_separator);
+
+        if (!g_spectator_client.connect(spectate_host.c_str(), spectate_port))
+        {
+            shutdown();
+            return 1;
+        }
+    }
+    if (broadcast_port >= 0 && !g_spectator_broadcaster.open((uint16_t) broadcast_port))
+    {
+        shutdown();
+        return 1;
+    }
+
+    if (record_filepath != nullptr)
+    {
+        InputLogHeader header;
+        header.match_count = (uint16_t) match_count;
+        header.seed = g_seed;
+        header.build_hash = simulation_build_hash();
+        header.tick_ms = FIXED_TIMESTEP_MS;
+        g_input_log_writer.open(record_filepath, header);
+    }
 
     while (g_app_status == RUNNING)
     {
         process_input();
         update();
         render();
+        end_frame();
+
+        if (g_app_status == RUNNING && is_quiescent())
+        {
+            // Nothing can change until an event arrives, so block instead of redrawing the same frame.
+            // A NULL event leaves whatever woke us in the queue for process_input(). A timeout, or an
+            // error, just runs one more frame, after which the loop checks whether it is still idle.
+            SDL_WaitEventTimeout(NULL, IDLE_WAIT_TIMEOUT_MS);
+
+            // The time spent asleep must not reach the simulation as one huge step
+            g_previous_ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND;
+            g_simulation_ms = SDL_GetTicks();
+        }
     }
 
     shutdown();
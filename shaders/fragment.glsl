@@ -1,5 +1,6 @@
 uniform vec4 color;
+varying vec4 colourVar;
 
 void main() {
-    gl_FragColor = color;
+    gl_FragColor = color * colourVar;
 }
@@ -0,0 +1,13 @@
+uniform sampler2D diffuse;
+uniform vec2 texelStep;
+varying vec2 texCoordVar;
+
+void main() {
+    // 9-tap gaussian folded into 5 bilinear fetches
+    vec4 sum = texture2D(diffuse, texCoordVar) * 0.2270270270;
+    sum += texture2D(diffuse, texCoordVar + texelStep * 1.3846153846) * 0.3162162162;
+    sum += texture2D(diffuse, texCoordVar - texelStep * 1.3846153846) * 0.3162162162;
+    sum += texture2D(diffuse, texCoordVar + texelStep * 3.2307692308) * 0.0702702703;
+    sum += texture2D(diffuse, texCoordVar - texelStep * 3.2307692308) * 0.0702702703;
+    gl_FragColor = sum;
+}
@@ -0,0 +1,19 @@
+uniform sampler2D diffuse;
+uniform sampler2D bloom;
+uniform vec3 effectStrength;  // bloom, vignette, scanlines
+varying vec2 texCoordVar;
+
+void main() {
+    vec3 colour = texture2D(diffuse, texCoordVar).rgb;
+
+    if (effectStrength.x > 0.0) {
+        colour += texture2D(bloom, texCoordVar).rgb * effectStrength.x;
+    }
+
+    vec2 from_centre = texCoordVar - 0.5;
+    colour *= 1.0 - effectStrength.y * dot(from_centre, from_centre) * 2.0;
+
+    colour *= 1.0 - effectStrength.z * mod(floor(gl_FragCoord.y), 2.0);
+
+    gl_FragColor = vec4(colour, 1.0);
+}
@@ -0,0 +1,5 @@
+varying vec4 colourVar;
+
+void main() {
+    gl_FragColor = colourVar;
+}
@@ -1,11 +1,15 @@
 attribute vec4 position;
+attribute vec4 colour;
 
 uniform mat4 modelMatrix;
 uniform mat4 viewMatrix;
 uniform mat4 projectionMatrix;
 
+varying vec4 colourVar;
+
 void main()
 {
 	vec4 p = viewMatrix * modelMatrix  * position;
+    colourVar = colour;
 	gl_Position = projectionMatrix * p;
 }
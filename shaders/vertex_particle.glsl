@@ -0,0 +1,19 @@
+attribute float positionX;
+attribute float positionY;
+attribute vec4 colour;
+attribute float fade;
+
+uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+uniform float pointSize;
+
+varying vec4 colourVar;
+
+void main()
+{
+	vec4 p = viewMatrix * modelMatrix  * vec4(positionX, positionY, 0.0, 1.0);
+    colourVar = vec4(colour.rgb, colour.a * fade);
+    gl_PointSize = pointSize;
+	gl_Position = projectionMatrix * p;
+}
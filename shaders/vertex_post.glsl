@@ -0,0 +1,10 @@
+attribute vec4 position;
+
+varying vec2 texCoordVar;
+
+void main()
+{
+    // Full-screen quad given directly in clip space
+    texCoordVar = position.xy * 0.5 + 0.5;
+	gl_Position = position;
+}